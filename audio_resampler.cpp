@@ -101,3 +101,46 @@ int audio_resampler::convert(uint8_t **out_buffer, int out_samples, const AVFram
 
     return swr_convert(swr_ctx_, out_buffer, out_samples, const_cast<const uint8_t **>(in_frame->data), in_frame->nb_samples);
 }
+
+int audio_resampler::drain(uint8_t **out_buffer, int out_samples)
+{
+    if (swr_ctx_ == nullptr)
+    {
+        return 0;
+    }
+
+    return swr_convert(swr_ctx_, out_buffer, out_samples, nullptr, 0);
+}
+
+bool audio_resampler::set_compensation(int sample_delta, int compensation_distance)
+{
+    if (swr_ctx_ == nullptr)
+    {
+        LOG_WARN("audio resampler set compensation called with null context");
+        return false;
+    }
+
+    const int ret = swr_set_compensation(swr_ctx_, sample_delta, compensation_distance);
+    if (ret < 0)
+    {
+        LOG_ERROR("audio resampler set compensation failed code {}", ret);
+        return false;
+    }
+    return true;
+}
+
+void audio_resampler::reset()
+{
+    if (swr_ctx_ != nullptr)
+    {
+        swr_free(&swr_ctx_);
+    }
+#if LIBAVUTIL_VERSION_MAJOR >= 57
+    av_channel_layout_uninit(&in_ch_layout_);
+    av_channel_layout_default(&in_ch_layout_, 0);
+#else
+    in_ch_layout_ = 0;
+#endif
+    in_rate_ = 0;
+    in_fmt_ = AV_SAMPLE_FMT_NONE;
+}
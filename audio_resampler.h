@@ -30,6 +30,9 @@ class audio_resampler
               int src_rate,
               AVSampleFormat src_fmt);
     int convert(uint8_t **out_buffer, int out_samples, const AVFrame *in_frame);
+    int drain(uint8_t **out_buffer, int out_samples);
+    bool set_compensation(int sample_delta, int compensation_distance);
+    void reset();
 
    private:
     SwrContext *swr_ctx_ = nullptr;
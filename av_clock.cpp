@@ -4,31 +4,80 @@ extern "C"
 #include <libavutil/time.h>
 }
 
-av_clock::av_clock() { update_time(); }
+av_clock::av_clock()
+{
+    const uint32_t begin = begin_store();
+    snapshot s;
+    s.last_updated = now_seconds();
+    end_store(s, begin);
+}
 
-void av_clock::set(double p, int serial)
+double av_clock::now_seconds() { return static_cast<double>(av_gettime_relative()) / 1000000.0; }
+
+double av_clock::current_pts(const snapshot &s, double now)
 {
-    pts_.store(p);
-    serial_.store(serial);
-    if (paused_.load())
+    if (s.paused)
     {
-        pts_at_pause_ = p;
+        return s.pts;
     }
-    update_time();
+    return s.pts + ((now - s.last_updated) * s.rate);
 }
 
-double av_clock::get() const
+av_clock::snapshot av_clock::fields() const
+{
+    snapshot s;
+    s.pts = pts_.load(std::memory_order_acquire);
+    s.last_updated = last_updated_.load(std::memory_order_acquire);
+    s.rate = rate_.load(std::memory_order_acquire);
+    s.paused = paused_.load(std::memory_order_acquire);
+    s.serial = serial_.load(std::memory_order_acquire);
+    return s;
+}
+
+av_clock::snapshot av_clock::load(double &now) const
 {
-    if (paused_.load())
+    snapshot s;
+    uint32_t begin = 0;
+    do
     {
-        return pts_at_pause_;
-    }
-    auto now = static_cast<double>(av_gettime_relative());
-    const double time_elapsed = (now / 1000000.0) - last_updated_.load();
-    return pts_.load() + (time_elapsed * rate_.load());
+        begin = sequence_.load(std::memory_order_acquire);
+        s = fields();
+        now = now_seconds();
+    } while ((begin & 1U) != 0 || begin != sequence_.load(std::memory_order_acquire));
+    return s;
+}
+
+uint32_t av_clock::begin_store() { return sequence_.fetch_add(1, std::memory_order_seq_cst); }
+
+void av_clock::end_store(const snapshot &s, uint32_t begin)
+{
+    pts_.store(s.pts, std::memory_order_relaxed);
+    last_updated_.store(s.last_updated, std::memory_order_relaxed);
+    rate_.store(s.rate, std::memory_order_relaxed);
+    paused_.store(s.paused, std::memory_order_relaxed);
+    serial_.store(s.serial, std::memory_order_relaxed);
+    sequence_.store(begin + 2, std::memory_order_release);
+}
+
+void av_clock::set(double p, int serial)
+{
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const uint32_t begin = begin_store();
+    snapshot s = fields();
+    s.pts = p;
+    s.serial = serial;
+    s.last_updated = now_seconds();
+    end_store(s, begin);
+}
+
+double av_clock::get() const
+{
+    double now = 0.0;
+    const snapshot s = load(now);
+    return current_pts(s, now);
 }
 
-int av_clock::serial() const { return serial_.load(); }
+int av_clock::serial() const { return serial_.load(std::memory_order_acquire); }
 
 void av_clock::set_rate(double rate)
 {
@@ -37,29 +86,40 @@ void av_clock::set_rate(double rate)
         return;
     }
 
-    const double current = get();
-    pts_.store(current);
-    rate_.store(rate);
-    update_time();
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const uint32_t begin = begin_store();
+    snapshot s = fields();
+    const double now = now_seconds();
+    s.pts = current_pts(s, now);
+    s.last_updated = now;
+    s.rate = rate;
+    end_store(s, begin);
 }
 
-double av_clock::rate() const { return rate_.load(); }
+double av_clock::rate() const { return rate_.load(std::memory_order_acquire); }
 
 void av_clock::pause()
 {
-    pts_at_pause_ = get();
-    paused_.store(true);
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const uint32_t begin = begin_store();
+    snapshot s = fields();
+    const double now = now_seconds();
+    s.pts = current_pts(s, now);
+    s.last_updated = now;
+    s.paused = true;
+    end_store(s, begin);
 }
 
 void av_clock::resume()
 {
-    pts_.store(pts_at_pause_);
-    update_time();
-    paused_.store(false);
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const uint32_t begin = begin_store();
+    snapshot s = fields();
+    s.last_updated = now_seconds();
+    s.paused = false;
+    end_store(s, begin);
 }
 
-void av_clock::update_time()
-{
-    auto now = static_cast<double>(av_gettime_relative());
-    last_updated_.store(now / 1000000.0);
-}
+void av_clock::set_master(clock_master master) { master_.store(master); }
+
+clock_master av_clock::master() const { return master_.load(); }
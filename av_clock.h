@@ -2,6 +2,15 @@
 #define AV_CLOCK_H
 
 #include <atomic>
+#include <mutex>
+#include <cstdint>
+
+enum class clock_master
+{
+    audio,
+    video,
+    external
+};
 
 class av_clock
 {
@@ -16,18 +25,35 @@ class av_clock
     [[nodiscard]] double rate() const;
     void pause();
     void resume();
+    void set_master(clock_master master);
+    [[nodiscard]] clock_master master() const;
 
    private:
-    void update_time();
+    struct snapshot
+    {
+        double pts = 0.0;
+        double last_updated = 0.0;
+        double rate = 1.0;
+        bool paused = false;
+        int serial = -1;
+    };
+
+    [[nodiscard]] snapshot load(double &now) const;
+    [[nodiscard]] snapshot fields() const;
+    [[nodiscard]] uint32_t begin_store();
+    void end_store(const snapshot &s, uint32_t begin);
+    [[nodiscard]] static double now_seconds();
+    [[nodiscard]] static double current_pts(const snapshot &s, double now);
 
    private:
-    double pts_at_pause_ = 0.0;
+    std::mutex write_mutex_;
+    std::atomic<uint32_t> sequence_{0};
     std::atomic<double> pts_{0.0};
-    std::atomic<bool> paused_{false};
     std::atomic<double> last_updated_{0.0};
     std::atomic<double> rate_{1.0};
-
+    std::atomic<bool> paused_{false};
     std::atomic<int> serial_{-1};
+    std::atomic<clock_master> master_{clock_master::audio};
 };
 
 #endif
@@ -16,6 +16,12 @@ decoder::~decoder()
 
 void decoder::stop() { aborted_.store(true); }
 
+void decoder::set_skip_nonkey(bool skip)
+{
+    LOG_INFO("decoder skip non key frames {} name {}", skip, name_);
+    skip_nonkey_.store(skip);
+}
+
 AVPixelFormat decoder::get_hw_format(AVCodecContext *ctx, const AVPixelFormat *pix_fmts)
 {
     auto *self = static_cast<decoder *>(ctx->opaque);
@@ -171,6 +177,7 @@ bool decoder::open(const AVCodecParameters *par,
     packet_queue_ = packet_queue;
     frame_queue_ = frame_queue;
     name_ = name;
+    aborted_.store(false);
     video_decoder_ = (par != nullptr && par->codec_type == AVMEDIA_TYPE_VIDEO);
 
     if (par == nullptr)
@@ -210,8 +217,6 @@ void decoder::run()
     std::shared_ptr<media_packet> pkt;
     int current_serial = 0;
 
-    aborted_.store(false);
-
     while (!aborted_.load())
     {
         if (!packet_queue_->pop(pkt))
@@ -247,6 +252,12 @@ void decoder::run()
         AVPacket *raw_pkt = (pkt != nullptr) ? pkt->raw() : nullptr;
         bool frame_emitted_for_packet = false;
 
+        const AVDiscard skip_frame = skip_nonkey_.load() ? AVDISCARD_NONKEY : AVDISCARD_DEFAULT;
+        if (codec_ctx_->skip_frame != skip_frame)
+        {
+            codec_ctx_->skip_frame = skip_frame;
+        }
+
         int ret = avcodec_send_packet(codec_ctx_, raw_pkt);
         if (ret < 0)
         {
@@ -28,6 +28,7 @@ class decoder
 
     void run();
     void stop();
+    void set_skip_nonkey(bool skip);
     [[nodiscard]] bool using_hardware_decode() const { return using_hw_decode_; }
 
    private:
@@ -47,6 +48,7 @@ class decoder
     bool video_decoder_ = false;
     bool using_hw_decode_ = false;
     std::atomic<bool> aborted_{false};
+    std::atomic<bool> skip_nonkey_{false};
 };
 
 #endif
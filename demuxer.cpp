@@ -1,7 +1,45 @@
 #include <thread>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
 #include "demuxer.h"
 #include "log.h"
 
+extern "C"
+{
+#include <libavutil/time.h>
+}
+
+namespace
+{
+constexpr auto k_push_wait = std::chrono::milliseconds(20);
+constexpr size_t k_max_queue_growth = 16;
+constexpr int k_max_byte_seek_steps = 10;
+constexpr int k_byte_seek_probe_packets = 256;
+constexpr double k_byte_seek_tolerance_second = 1.0;
+constexpr int64_t k_min_byte_seek_window = 64 * 1024;
+constexpr double k_trick_hop_interval_second = 0.1;
+
+int index_entries_count(AVStream *stream)
+{
+#if LIBAVFORMAT_VERSION_MAJOR >= 59
+    return avformat_index_get_entries_count(stream);
+#else
+    return stream->nb_index_entries;
+#endif
+}
+
+const AVIndexEntry *keyframe_entry(AVStream *stream, int64_t timestamp, int flags)
+{
+#if LIBAVFORMAT_VERSION_MAJOR >= 59
+    return avformat_index_get_entry_from_timestamp(stream, timestamp, flags);
+#else
+    const int index = av_index_search_timestamp(stream, timestamp, flags);
+    return index >= 0 ? &stream->index_entries[index] : nullptr;
+#endif
+}
+}  // namespace
+
 demuxer::~demuxer()
 {
     LOG_INFO("demuxer destroying");
@@ -18,14 +56,83 @@ void demuxer::stop() { abort_.store(true); }
 int demuxer::interrupt_cb(void *ctx)
 {
     auto *self = static_cast<demuxer *>(ctx);
-    if (self->abort_.load())
+    if (self->abort_.load() || self->seek_req_.load() >= 0.0)
     {
         return 1;
     }
     return 0;
 }
 
-void demuxer::set_seek_cb(std::function<void(double)> cb) { seek_cb_ = std::move(cb); }
+void demuxer::set_seek_cb(std::function<void(double, double)> cb) { seek_cb_ = std::move(cb); }
+
+void demuxer::set_audio_muted(bool muted)
+{
+    LOG_INFO("demuxer audio muted {}", muted);
+    if (audio_muted_.exchange(muted) != muted)
+    {
+        restore_queue_sizes();
+    }
+}
+
+void demuxer::set_trick_rate(double rate)
+{
+    LOG_INFO("demuxer trick rate {}", rate);
+    trick_boundary_reached_.store(false);
+    if (trick_rate_.exchange(rate) != rate)
+    {
+        restore_queue_sizes();
+    }
+}
+
+[[nodiscard]] bool demuxer::trick_boundary_reached() const { return trick_boundary_reached_.load(); }
+
+bool demuxer::seek_pending() const { return seek_req_.load() >= 0.0; }
+
+bool demuxer::hop_keyframe(int64_t timestamp, double rate)
+{
+    if (timestamp == AV_NOPTS_VALUE || video_index_ < 0)
+    {
+        return false;
+    }
+
+    AVStream *stream = fmt_ctx_->streams[video_index_];
+    const double spacing = std::abs(rate) * k_trick_hop_interval_second;
+    const int64_t step = std::max<int64_t>(1, av_rescale_q(static_cast<int64_t>(spacing * AV_TIME_BASE), AV_TIME_BASE_Q, stream->time_base));
+
+    int ret = 0;
+    if (rate > 0.0)
+    {
+        if (index_entries_count(stream) <= 0)
+        {
+            return false;
+        }
+        const int64_t target = timestamp + step;
+        ret = avformat_seek_file(fmt_ctx_, video_index_, target, target, INT64_MAX, 0);
+    }
+    else
+    {
+        const int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+        if (timestamp <= start)
+        {
+            LOG_INFO("demuxer trick rewind reached start");
+            trick_boundary_reached_.store(true);
+            return false;
+        }
+        const int64_t target = std::max(start, timestamp - step);
+        ret = avformat_seek_file(fmt_ctx_, video_index_, INT64_MIN, target, timestamp - 1, 0);
+    }
+
+    if (ret < 0)
+    {
+        LOG_DEBUG("demuxer keyframe hop from {} failed code {}", timestamp, ret);
+        if (rate < 0.0)
+        {
+            trick_boundary_reached_.store(true);
+        }
+        return false;
+    }
+    return true;
+}
 
 [[nodiscard]] AVCodecParameters *demuxer::codec_par(int stream_index) const
 {
@@ -70,6 +177,23 @@ QString demuxer::format_name() const
 
 [[nodiscard]] bool demuxer::eof_reached() const { return eof_reached_.load(); }
 
+[[nodiscard]] double demuxer::last_seek_latency_ms() const { return last_seek_latency_ms_.load(); }
+
+bool demuxer::realtime() const
+{
+    if (fmt_ctx_ == nullptr || fmt_ctx_->iformat == nullptr || fmt_ctx_->iformat->name == nullptr)
+    {
+        return false;
+    }
+
+    const std::string name = fmt_ctx_->iformat->name;
+    if (name == "rtp" || name == "rtsp" || name == "sdp")
+    {
+        return true;
+    }
+    return url_.rfind("rtp:", 0) == 0 || url_.rfind("udp:", 0) == 0 || url_.rfind("srt:", 0) == 0;
+}
+
 AVRational demuxer::frame_rate(int stream_index) const
 {
     if (fmt_ctx_ == nullptr || stream_index < 0 || stream_index >= static_cast<int>(fmt_ctx_->nb_streams))
@@ -95,10 +219,11 @@ AVRational demuxer::frame_rate(int stream_index) const
     return AVRational{0, 1};
 }
 
-void demuxer::seek(double seconds)
+void demuxer::seek(double seconds, bool precise)
 {
-    LOG_INFO("demuxer seek requested to {}", seconds);
+    LOG_INFO("demuxer seek requested to {} precise {}", seconds, precise);
     eof_reached_.store(false);
+    trick_boundary_reached_.store(false);
     if (video_queue_ != nullptr)
     {
         video_queue_->add_serial();
@@ -107,7 +232,13 @@ void demuxer::seek(double seconds)
     {
         audio_queue_->add_serial();
     }
-    seek_req_.store(seconds);
+    seek_req_time_.store(av_gettime_relative());
+    seek_precise_.store(precise);
+    const double superseded = seek_req_.exchange(seconds);
+    if (superseded >= 0.0)
+    {
+        LOG_INFO("demuxer seek to {} supersedes pending seek to {}", seconds, superseded);
+    }
 
     if (video_queue_ != nullptr)
     {
@@ -119,12 +250,250 @@ void demuxer::seek(double seconds)
     }
 }
 
+bool demuxer::push_packet(safe_queue<std::shared_ptr<media_packet>> *queue,
+                          safe_queue<std::shared_ptr<media_packet>> *other_queue,
+                          size_t base_size,
+                          std::shared_ptr<media_packet> &pkt,
+                          const char *name)
+{
+    while (!abort_.load())
+    {
+        if (queue->try_push_for(pkt, k_push_wait))
+        {
+            return true;
+        }
+        if (queue->aborted())
+        {
+            return false;
+        }
+
+        if (other_queue == nullptr || !other_queue->empty() || other_stream_dropped())
+        {
+            continue;
+        }
+
+        const size_t current_size = queue->max_size();
+        const size_t size_limit = std::max<size_t>(base_size, 1) * k_max_queue_growth;
+        if (current_size >= size_limit)
+        {
+            continue;
+        }
+
+        const size_t grown_size = std::min(current_size * 2, size_limit);
+        LOG_WARN("demuxer {} queue full while other stream starved, growing capacity {} -> {}", name, current_size, grown_size);
+        queue->set_max_size(grown_size);
+    }
+    return false;
+}
+
+void demuxer::restore_queue_sizes()
+{
+    if (video_queue_ != nullptr && video_queue_base_size_ > 0)
+    {
+        video_queue_->set_max_size(video_queue_base_size_);
+    }
+    if (audio_queue_ != nullptr && audio_queue_base_size_ > 0)
+    {
+        audio_queue_->set_max_size(audio_queue_base_size_);
+    }
+}
+
+bool demuxer::other_stream_dropped() const { return trick_rate_.load() != 0.0 || audio_muted_.load(); }
+
+int demuxer::reference_stream() const { return video_index_ >= 0 ? video_index_ : audio_index_; }
+
+bool demuxer::byte_seek_possible() const
+{
+    if (fmt_ctx_->iformat == nullptr || (fmt_ctx_->iformat->flags & AVFMT_NO_BYTE_SEEK) != 0)
+    {
+        return false;
+    }
+    return fmt_ctx_->pb != nullptr && (fmt_ctx_->pb->seekable & AVIO_SEEKABLE_NORMAL) != 0 && avio_size(fmt_ctx_->pb) > 0;
+}
+
+bool demuxer::byte_seek_preferred() const
+{
+    if (!byte_seek_possible())
+    {
+        return false;
+    }
+    const int stream_index = reference_stream();
+    return stream_index >= 0 && index_entries_count(fmt_ctx_->streams[stream_index]) == 0;
+}
+
+double demuxer::probe_time_at(int64_t offset)
+{
+    if (avformat_seek_file(fmt_ctx_, -1, INT64_MIN, offset, INT64_MAX, AVSEEK_FLAG_BYTE) < 0)
+    {
+        return -1.0;
+    }
+
+    AVPacket *pkt = av_packet_alloc();
+    if (pkt == nullptr)
+    {
+        return -1.0;
+    }
+
+    const int stream_index = reference_stream();
+    double found = -1.0;
+    for (int i = 0; i < k_byte_seek_probe_packets && !abort_.load(); ++i)
+    {
+        if (av_read_frame(fmt_ctx_, pkt) < 0)
+        {
+            break;
+        }
+
+        const int64_t timestamp = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+        if (pkt->stream_index == stream_index && timestamp != AV_NOPTS_VALUE)
+        {
+            found = static_cast<double>(timestamp) * av_q2d(fmt_ctx_->streams[stream_index]->time_base);
+            av_packet_unref(pkt);
+            break;
+        }
+        av_packet_unref(pkt);
+    }
+
+    av_packet_free(&pkt);
+    return found;
+}
+
+bool demuxer::seek_by_bytes(double target, double &landed)
+{
+    const int64_t file_size = avio_size(fmt_ctx_->pb);
+    double bytes_per_second = 0.0;
+    if (fmt_ctx_->bit_rate > 0)
+    {
+        bytes_per_second = static_cast<double>(fmt_ctx_->bit_rate) / 8.0;
+    }
+    else if (duration() > 0.0)
+    {
+        bytes_per_second = static_cast<double>(file_size) / duration();
+    }
+    if (file_size <= 0 || bytes_per_second <= 0.0 || reference_stream() < 0)
+    {
+        return false;
+    }
+
+    const double start_second = fmt_ctx_->start_time != AV_NOPTS_VALUE ? static_cast<double>(fmt_ctx_->start_time) / AV_TIME_BASE : 0.0;
+    int64_t low = 0;
+    int64_t high = file_size;
+    auto offset = std::clamp(static_cast<int64_t>((target - start_second) * bytes_per_second), int64_t{0}, file_size - 1);
+    int64_t best_offset = offset;
+    double best_time = target;
+    bool found_lower = false;
+
+    int step = 0;
+    for (; step < k_max_byte_seek_steps && !abort_.load(); ++step)
+    {
+        const double found = probe_time_at(offset);
+        if (seek_req_.load() >= 0.0)
+        {
+            LOG_INFO("demuxer byte seek to {} superseded after {} steps", target, step);
+            return false;
+        }
+
+        if (found >= 0.0 && found <= target)
+        {
+            low = offset;
+            best_offset = offset;
+            best_time = found;
+            found_lower = true;
+            if (target - found <= k_byte_seek_tolerance_second)
+            {
+                break;
+            }
+        }
+        else
+        {
+            high = offset;
+        }
+
+        if (high - low <= k_min_byte_seek_window)
+        {
+            break;
+        }
+        offset = low + ((high - low) / 2);
+    }
+
+    if (found_lower)
+    {
+        LOG_INFO("demuxer byte seek to {} landed at {:.3f} offset {} after {} steps", target, best_time, best_offset, step + 1);
+    }
+    else
+    {
+        LOG_WARN("demuxer byte seek to {} found no timestamp before the target after {} steps, using bitrate estimate offset {}", target, step + 1, best_offset);
+    }
+    if (avformat_seek_file(fmt_ctx_, -1, INT64_MIN, best_offset, INT64_MAX, AVSEEK_FLAG_BYTE) < 0)
+    {
+        return false;
+    }
+    landed = best_time;
+    return true;
+}
+
+int64_t demuxer::cheapest_keyframe_target(int stream_index, int64_t timestamp) const
+{
+    AVStream *stream = fmt_ctx_->streams[stream_index];
+    const AVIndexEntry *before = keyframe_entry(stream, timestamp, AVSEEK_FLAG_BACKWARD);
+    const AVIndexEntry *after = keyframe_entry(stream, timestamp, 0);
+    if (before == nullptr || after == nullptr || after->timestamp <= before->timestamp)
+    {
+        return timestamp;
+    }
+
+    if (after->timestamp - timestamp < timestamp - before->timestamp)
+    {
+        return after->timestamp;
+    }
+    return before->timestamp;
+}
+
+bool demuxer::seek_to(double target, bool precise, double &landed)
+{
+    if (byte_seek_preferred())
+    {
+        return seek_by_bytes(target, landed);
+    }
+
+    int ret = -1;
+    landed = target;
+    const int stream_index = video_index_;
+    if (!precise && stream_index >= 0 && index_entries_count(fmt_ctx_->streams[stream_index]) > 0)
+    {
+        const AVRational time_base = fmt_ctx_->streams[stream_index]->time_base;
+        const int64_t stream_target = av_rescale_q(static_cast<int64_t>(target * AV_TIME_BASE), AV_TIME_BASE_Q, time_base);
+        const int64_t keyframe_target = cheapest_keyframe_target(stream_index, stream_target);
+        landed = static_cast<double>(keyframe_target) * av_q2d(time_base);
+        LOG_INFO("demuxer fast seek to {} snapping to keyframe at {:.3f}", target, landed);
+        ret = avformat_seek_file(fmt_ctx_, stream_index, INT64_MIN, keyframe_target, keyframe_target, 0);
+    }
+    else
+    {
+        const auto seek_target = static_cast<int64_t>(target * AV_TIME_BASE);
+        ret = avformat_seek_file(fmt_ctx_, -1, INT64_MIN, seek_target, INT64_MAX, AVSEEK_FLAG_BACKWARD);
+    }
+    if (ret >= 0)
+    {
+        return true;
+    }
+
+    if (seek_req_.load() >= 0.0)
+    {
+        return false;
+    }
+
+    LOG_WARN("demuxer time seek to {} failed code {}, trying byte seek", target, ret);
+    return byte_seek_possible() && seek_by_bytes(target, landed);
+}
+
 bool demuxer::open(const std::string &url, safe_queue<std::shared_ptr<media_packet>> *v_q, safe_queue<std::shared_ptr<media_packet>> *a_q)
 {
     LOG_INFO("demuxer opening url {}", url);
     url_ = url;
     video_queue_ = v_q;
     audio_queue_ = a_q;
+    video_queue_base_size_ = video_queue_ != nullptr ? video_queue_->max_size() : 0;
+    audio_queue_base_size_ = audio_queue_ != nullptr ? audio_queue_->max_size() : 0;
     abort_.store(false);
     eof_reached_.store(false);
 
@@ -174,15 +543,10 @@ void demuxer::run()
         if (target >= 0.0)
         {
             LOG_INFO("demuxer performing seek to {}", target);
-            const auto seek_target = static_cast<int64_t>(target * AV_TIME_BASE);
-
-            const int64_t seek_min = INT64_MIN;
-            const int64_t seek_max = INT64_MAX;
-
-            const int ret = avformat_seek_file(fmt_ctx_, -1, seek_min, seek_target, seek_max, AVSEEK_FLAG_BACKWARD);
-            if (ret < 0)
+            double landed = target;
+            if (!seek_to(target, seek_precise_.load(), landed))
             {
-                LOG_ERROR("demuxer seek failed code {}", ret);
+                LOG_ERROR("demuxer seek to {} failed", target);
             }
             else
             {
@@ -205,6 +569,7 @@ void demuxer::run()
                 {
                     audio_queue_->clear();
                 }
+                restore_queue_sizes();
 
                 if (video_queue_ != nullptr)
                 {
@@ -219,17 +584,22 @@ void demuxer::run()
                     audio_queue_->push(pkt);
                 }
 
+                const auto latency_ms = static_cast<double>(av_gettime_relative() - seek_req_time_.load()) / 1000.0;
+                last_seek_latency_ms_.store(latency_ms);
+                LOG_INFO("demuxer seek to {} landed at {:.3f} completed in {:.1f} ms", target, landed, latency_ms);
+
                 if (seek_cb_)
                 {
-                    seek_cb_(target);
+                    seek_cb_(target, landed);
                 }
 
                 eof_reached = false;
                 eof_reached_.store(false);
+                trick_boundary_reached_.store(false);
             }
         }
 
-        if (eof_reached)
+        if (eof_reached || trick_boundary_reached_.load())
         {
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
             continue;
@@ -262,15 +632,27 @@ void demuxer::run()
                 LOG_INFO("demuxer aborted during read frame");
                 break;
             }
+            if (seek_req_.load() >= 0.0)
+            {
+                LOG_INFO("demuxer read frame interrupted by pending seek");
+                continue;
+            }
             LOG_ERROR("demuxer read frame failed code {}", ret);
             eof_reached = true;
             continue;
         }
 
+        const double trick_rate = trick_rate_.load();
+        if (trick_rate != 0.0 && (pkt->raw()->stream_index != video_index_ || (pkt->raw()->flags & AV_PKT_FLAG_KEY) == 0))
+        {
+            continue;
+        }
+
         if (pkt->raw()->stream_index == video_index_ && video_queue_ != nullptr)
         {
+            const int64_t keyframe_ts = pkt->raw()->pts != AV_NOPTS_VALUE ? pkt->raw()->pts : pkt->raw()->dts;
             pkt->set_serial(video_queue_->serial());
-            if (!video_queue_->push(pkt))
+            if (!push_packet(video_queue_, audio_index_ >= 0 ? audio_queue_ : nullptr, video_queue_base_size_, pkt, "video"))
             {
                 if (seek_req_.load() >= 0.0)
                 {
@@ -279,11 +661,15 @@ void demuxer::run()
                 LOG_INFO("demuxer video queue push failed");
                 break;
             }
+            if (trick_rate != 0.0 && seek_req_.load() < 0.0)
+            {
+                hop_keyframe(keyframe_ts, trick_rate);
+            }
         }
-        else if (pkt->raw()->stream_index == audio_index_ && audio_queue_ != nullptr)
+        else if (pkt->raw()->stream_index == audio_index_ && audio_queue_ != nullptr && !audio_muted_.load())
         {
             pkt->set_serial(audio_queue_->serial());
-            if (!audio_queue_->push(pkt))
+            if (!push_packet(audio_queue_, video_index_ >= 0 ? video_queue_ : nullptr, audio_queue_base_size_, pkt, "audio"))
             {
                 if (seek_req_.load() >= 0.0)
                 {
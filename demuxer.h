@@ -20,12 +20,14 @@ class demuxer
    public:
     bool open(const std::string &url, safe_queue<std::shared_ptr<media_packet>> *v_q, 
               safe_queue<std::shared_ptr<media_packet>> *a_q);
-    void seek(double seconds);
+    void seek(double seconds, bool precise = true);
 
     void stop();
     void run();
 
-    void set_seek_cb(std::function<void(double)> cb);
+    void set_seek_cb(std::function<void(double, double)> cb);
+    void set_audio_muted(bool muted);
+    void set_trick_rate(double rate);
 
    public:
     [[nodiscard]] int video_index() const;
@@ -36,9 +38,28 @@ class demuxer
     [[nodiscard]] AVRational frame_rate(int stream_index) const;
     [[nodiscard]] AVCodecParameters *codec_par(int stream_index) const;
     [[nodiscard]] bool eof_reached() const;
+    [[nodiscard]] double last_seek_latency_ms() const;
+    [[nodiscard]] bool realtime() const;
+    [[nodiscard]] bool trick_boundary_reached() const;
+    [[nodiscard]] bool seek_pending() const;
 
    private:
     static int interrupt_cb(void *ctx);
+    bool push_packet(safe_queue<std::shared_ptr<media_packet>> *queue,
+                     safe_queue<std::shared_ptr<media_packet>> *other_queue,
+                     size_t base_size,
+                     std::shared_ptr<media_packet> &pkt,
+                     const char *name);
+    void restore_queue_sizes();
+    [[nodiscard]] bool other_stream_dropped() const;
+    [[nodiscard]] int reference_stream() const;
+    [[nodiscard]] bool byte_seek_possible() const;
+    [[nodiscard]] bool byte_seek_preferred() const;
+    double probe_time_at(int64_t offset);
+    bool seek_by_bytes(double target, double &landed);
+    bool seek_to(double target, bool precise, double &landed);
+    [[nodiscard]] int64_t cheapest_keyframe_target(int stream_index, int64_t timestamp) const;
+    bool hop_keyframe(int64_t timestamp, double rate);
 
    private:
     std::string url_;
@@ -46,13 +67,21 @@ class demuxer
     int audio_index_ = -1;
     AVFormatContext *fmt_ctx_ = nullptr;
     std::atomic<double> seek_req_{-1.0};
+    std::atomic<int64_t> seek_req_time_{0};
+    std::atomic<bool> seek_precise_{true};
+    std::atomic<double> last_seek_latency_ms_{0.0};
 
     std::atomic<bool> abort_{false};
     std::atomic<bool> eof_reached_{false};
+    std::atomic<bool> audio_muted_{false};
+    std::atomic<double> trick_rate_{0.0};
+    std::atomic<bool> trick_boundary_reached_{false};
     safe_queue<std::shared_ptr<media_packet>> *video_queue_ = nullptr;
     safe_queue<std::shared_ptr<media_packet>> *audio_queue_ = nullptr;
+    size_t video_queue_base_size_ = 0;
+    size_t audio_queue_base_size_ = 0;
 
-    std::function<void(double)> seek_cb_ = nullptr;
+    std::function<void(double, double)> seek_cb_ = nullptr;
 };
 
 #endif
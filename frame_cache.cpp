@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include "log.h"
+#include "frame_cache.h"
+
+namespace
+{
+constexpr size_t k_min_cached_frames = 16;
+}  // namespace
+
+frame_cache::frame_cache(size_t byte_budget) : byte_budget_(byte_budget), frame_limit_(std::numeric_limits<size_t>::max()) {}
+
+size_t frame_cache::frame_bytes(const AVFrame *frame)
+{
+    size_t bytes = 0;
+    for (AVBufferRef *buffer : frame->buf)
+    {
+        if (buffer != nullptr)
+        {
+            bytes += static_cast<size_t>(buffer->size);
+        }
+    }
+    return bytes;
+}
+
+void frame_cache::insert(double pts, int serial, bool keyframe, std::shared_ptr<media_frame> frame)
+{
+    if (frame == nullptr || frame->raw() == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (serial != serial_)
+    {
+        clear_locked();
+        serial_ = serial;
+    }
+
+    if (keyframe && pts > gop_start_)
+    {
+        previous_gop_start_ = gop_start_;
+        gop_start_ = pts;
+        if (previous_gop_start_ >= 0.0)
+        {
+            auto end = entries_.lower_bound(previous_gop_start_);
+            for (auto it = entries_.begin(); it != end;)
+            {
+                bytes_ -= it->second.bytes;
+                evictions_++;
+                it = entries_.erase(it);
+            }
+        }
+    }
+
+    auto existing = entries_.find(pts);
+    if (existing != entries_.end())
+    {
+        bytes_ -= existing->second.bytes;
+        entries_.erase(existing);
+    }
+
+    entry item;
+    item.bytes = frame_bytes(frame->raw());
+    item.keyframe = keyframe;
+    item.frame = std::move(frame);
+    bytes_ += item.bytes;
+    entries_.emplace(pts, std::move(item));
+    cursor_ = pts;
+
+    evict_locked();
+}
+
+void frame_cache::set_frame_limit(size_t frames)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_limit_ = std::max<size_t>(frames, 1);
+    evict_locked();
+}
+
+void frame_cache::evict_locked()
+{
+    while ((bytes_ > byte_budget_ || entries_.size() > frame_limit_) && entries_.size() > 1)
+    {
+        auto front = entries_.begin();
+        auto back = std::prev(entries_.end());
+        auto victim = std::abs(front->first - cursor_) >= std::abs(back->first - cursor_) ? front : back;
+        bytes_ -= victim->second.bytes;
+        evictions_++;
+        entries_.erase(victim);
+    }
+}
+
+std::shared_ptr<media_frame> frame_cache::previous(double pts, int serial, double &out_pts)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.lower_bound(pts);
+    if (serial != serial_ || it == entries_.begin())
+    {
+        misses_++;
+        return nullptr;
+    }
+
+    --it;
+    hits_++;
+    cursor_ = it->first;
+    out_pts = it->first;
+    return it->second.frame;
+}
+
+std::shared_ptr<media_frame> frame_cache::next(double pts, int serial, double &out_pts)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.upper_bound(pts);
+    if (serial != serial_ || it == entries_.end())
+    {
+        misses_++;
+        return nullptr;
+    }
+
+    hits_++;
+    cursor_ = it->first;
+    out_pts = it->first;
+    return it->second.frame;
+}
+
+void frame_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    clear_locked();
+}
+
+void frame_cache::clear_locked()
+{
+    if (!entries_.empty())
+    {
+        LOG_DEBUG("frame cache cleared frames {} bytes {}", entries_.size(), bytes_);
+    }
+    entries_.clear();
+    bytes_ = 0;
+    cursor_ = 0.0;
+    gop_start_ = -1.0;
+    previous_gop_start_ = -1.0;
+}
+
+frame_cache::stats frame_cache::read() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats s;
+    s.frames = entries_.size();
+    s.bytes = bytes_;
+    s.byte_budget = byte_budget_;
+    s.hits = hits_;
+    s.misses = misses_;
+    s.evictions = evictions_;
+    return s;
+}
+
+size_t frame_cache::frame_budget_bytes() const { return byte_budget_ / k_min_cached_frames; }
@@ -0,0 +1,63 @@
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include "media_objects.h"
+
+class frame_cache
+{
+   public:
+    struct stats
+    {
+        size_t frames = 0;
+        size_t bytes = 0;
+        size_t byte_budget = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+   public:
+    explicit frame_cache(size_t byte_budget);
+
+   public:
+    void insert(double pts, int serial, bool keyframe, std::shared_ptr<media_frame> frame);
+    void set_frame_limit(size_t frames);
+    [[nodiscard]] std::shared_ptr<media_frame> previous(double pts, int serial, double &out_pts);
+    [[nodiscard]] std::shared_ptr<media_frame> next(double pts, int serial, double &out_pts);
+    void clear();
+    [[nodiscard]] stats read() const;
+    [[nodiscard]] size_t frame_budget_bytes() const;
+    [[nodiscard]] static size_t frame_bytes(const AVFrame *frame);
+
+   private:
+    struct entry
+    {
+        std::shared_ptr<media_frame> frame;
+        size_t bytes = 0;
+        bool keyframe = false;
+    };
+
+    void clear_locked();
+    void evict_locked();
+
+   private:
+    mutable std::mutex mutex_;
+    std::map<double, entry> entries_;
+    size_t byte_budget_ = 0;
+    size_t frame_limit_ = 0;
+    size_t bytes_ = 0;
+    int serial_ = -1;
+    double cursor_ = 0.0;
+    double gop_start_ = -1.0;
+    double previous_gop_start_ = -1.0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#include "frame_mailbox.h"
+
+frame_mailbox::~frame_mailbox() { delete slot_.exchange(nullptr, std::memory_order_acquire); }
+
+bool frame_mailbox::post(std::shared_ptr<media_frame> frame)
+{
+    auto *incoming = new slot{std::move(frame)};
+    slot *stale = slot_.exchange(incoming, std::memory_order_acq_rel);
+    posted_.fetch_add(1, std::memory_order_relaxed);
+    if (stale == nullptr)
+    {
+        return false;
+    }
+
+    replaced_.fetch_add(1, std::memory_order_relaxed);
+    delete stale;
+    return true;
+}
+
+bool frame_mailbox::take(std::shared_ptr<media_frame> &frame)
+{
+    slot *pending = slot_.exchange(nullptr, std::memory_order_acq_rel);
+    if (pending == nullptr)
+    {
+        return false;
+    }
+
+    frame = std::move(pending->frame);
+    delete pending;
+    return true;
+}
+
+void frame_mailbox::clear() { delete slot_.exchange(nullptr, std::memory_order_acq_rel); }
+
+uint64_t frame_mailbox::posted() const { return posted_.load(std::memory_order_relaxed); }
+
+uint64_t frame_mailbox::replaced() const { return replaced_.load(std::memory_order_relaxed); }
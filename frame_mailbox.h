@@ -0,0 +1,36 @@
+#ifndef FRAME_MAILBOX_H
+#define FRAME_MAILBOX_H
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include "media_objects.h"
+
+class frame_mailbox
+{
+   public:
+    frame_mailbox() = default;
+    ~frame_mailbox();
+    frame_mailbox(const frame_mailbox &) = delete;
+    frame_mailbox &operator=(const frame_mailbox &) = delete;
+
+   public:
+    bool post(std::shared_ptr<media_frame> frame);
+    [[nodiscard]] bool take(std::shared_ptr<media_frame> &frame);
+    void clear();
+    [[nodiscard]] uint64_t posted() const;
+    [[nodiscard]] uint64_t replaced() const;
+
+   private:
+    struct slot
+    {
+        std::shared_ptr<media_frame> frame;
+    };
+
+   private:
+    std::atomic<slot *> slot_{nullptr};
+    std::atomic<uint64_t> posted_{0};
+    std::atomic<uint64_t> replaced_{0};
+};
+
+#endif
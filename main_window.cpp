@@ -51,6 +51,8 @@ constexpr int k_resume_prompt_minimum_second = 10;
 constexpr int k_resume_prompt_near_end_margin_second = 30;
 constexpr int k_recent_history_menu_limit = 20;
 constexpr int k_seek_commit_delay_ms = 180;
+constexpr double k_preroll_lead_second = 8.0;
+constexpr double k_max_trick_rate = 32.0;
 constexpr int k_playlist_item_type_role = Qt::UserRole;
 constexpr int k_playlist_id_role = Qt::UserRole + 1;
 constexpr int k_playlist_row_role = Qt::UserRole + 2;
@@ -171,6 +173,20 @@ QString format_playback_rate_text(double rate)
     return text + "x";
 }
 
+QString clock_master_text(clock_master master)
+{
+    switch (master)
+    {
+        case clock_master::audio:
+            return "音频主时钟";
+        case clock_master::video:
+            return "视频主时钟";
+        case clock_master::external:
+            return "外部时钟";
+    }
+    return {};
+}
+
 QString format_frame_rate_text(AVRational frame_rate)
 {
     if (frame_rate.num <= 0 || frame_rate.den <= 0)
@@ -564,10 +580,22 @@ main_window::main_window(QWidget *parent) : QMainWindow(parent)
     video_widget_->setContextMenuPolicy(Qt::NoContextMenu);
     video_widget_->setAcceptDrops(true);
     video_frame_layout_->addWidget(video_widget_, 1);
+    connect(video_widget_,
+            &video_widget::drawable_size_changed,
+            this,
+            [this](int width, int height)
+            {
+                if (sync_thread_ != nullptr)
+                {
+                    sync_thread_->set_display_size(width, height);
+                }
+            });
 
     media_info_overlay_ = new QFrame(video_frame_);
     media_info_overlay_->setObjectName("mediaInfoOverlay");
     media_info_overlay_->setAttribute(Qt::WA_StyledBackground, true);
+    media_info_overlay_->setAttribute(Qt::WA_DontCreateNativeAncestors, true);
+    media_info_overlay_->setAttribute(Qt::WA_NativeWindow, true);
     media_info_overlay_->setAttribute(Qt::WA_TransparentForMouseEvents);
     media_info_overlay_->setStyleSheet(
         "QFrame#mediaInfoOverlay {"
@@ -835,6 +863,21 @@ main_window::main_window(QWidget *parent) : QMainWindow(parent)
                     set_playback_rate(rate);
                 });
     }
+    playback_rate_menu_->addSeparator();
+    for (double rate : {4.0, 8.0, 16.0, 32.0, -4.0, -8.0, -16.0, -32.0})
+    {
+        const QString label = QString(rate > 0.0 ? "快进 %1" : "快退 %1").arg(format_playback_rate_text(std::abs(rate)));
+        QAction *trick_action = playback_rate_menu_->addAction(label);
+        trick_action->setCheckable(true);
+        trick_action->setData(rate);
+        connect(trick_action,
+                &QAction::triggered,
+                this,
+                [this, rate]()
+                {
+                    start_trick_play(rate);
+                });
+    }
     update_playback_rate_button();
 
     control_layout->addWidget(control_bar, 1);
@@ -916,7 +959,7 @@ main_window::main_window(QWidget *parent) : QMainWindow(parent)
             {
                 if (pending_seek_target_ >= 0.0)
                 {
-                    execute_seek(pending_seek_target_);
+                    execute_seek(pending_seek_target_, false);
                 }
             });
 
@@ -1372,6 +1415,36 @@ void main_window::install_playback_shortcuts(QWidget *target)
                          LOG_INFO("key right pressed");
                          do_seek_relative(5.0);
                      });
+    install_shortcut(QKeySequence(Qt::Key_Period),
+                     [this]()
+                     {
+                         LOG_INFO("key step forward pressed");
+                         step_frame(1);
+                     });
+    install_shortcut(QKeySequence(Qt::Key_Comma),
+                     [this]()
+                     {
+                         LOG_INFO("key step backward pressed");
+                         step_frame(-1);
+                     });
+    install_shortcut(QKeySequence(Qt::Key_J),
+                     [this]()
+                     {
+                         LOG_INFO("key reverse playback pressed");
+                         toggle_reverse_playback();
+                     });
+    install_shortcut(QKeySequence(Qt::Key_BracketRight),
+                     [this]()
+                     {
+                         LOG_INFO("key trick forward pressed");
+                         cycle_trick_play(1);
+                     });
+    install_shortcut(QKeySequence(Qt::Key_BracketLeft),
+                     [this]()
+                     {
+                         LOG_INFO("key trick rewind pressed");
+                         cycle_trick_play(-1);
+                     });
     install_shortcut(QKeySequence(Qt::Key_Space),
                      [this]()
                      {
@@ -1582,10 +1655,12 @@ bool main_window::is_playlist_region_object(const QObject *watched) const
 
 void main_window::update_playback_rate_button()
 {
+    const double shown_rate = trick_rate_ != 0.0 ? trick_rate_ : playback_rate_;
+    const QString rate_text = trick_rate_ < 0.0 ? QString("-%1").arg(format_playback_rate_text(-trick_rate_)) : format_playback_rate_text(shown_rate);
     if (btn_playback_rate_ != nullptr)
     {
-        btn_playback_rate_->setText(format_playback_rate_text(playback_rate_));
-        btn_playback_rate_->setToolTip(QString("播放速度：%1").arg(format_playback_rate_text(playback_rate_)));
+        btn_playback_rate_->setText(rate_text);
+        btn_playback_rate_->setToolTip(QString("播放速度：%1").arg(rate_text));
     }
 
     if (playback_rate_menu_ == nullptr)
@@ -1596,7 +1671,7 @@ void main_window::update_playback_rate_button()
     for (QAction *action : playback_rate_menu_->actions())
     {
         const double item_rate = action->data().toDouble();
-        action->setChecked(std::abs(item_rate - playback_rate_) < 0.0001);
+        action->setChecked(std::abs(item_rate - shown_rate) < 0.0001);
     }
 }
 
@@ -1802,7 +1877,118 @@ void main_window::update_media_info_overlay()
         }
     }
 
-    lines.append(QString("<span style=\"color:#07c160; font-weight:600;\">状态</span> %1").arg(format_playback_rate_text(playback_rate_).toHtmlEscaped()));
+    QStringList status_parts;
+    status_parts.append(format_playback_rate_text(playback_rate_));
+    if (clock_ != nullptr)
+    {
+        if (trick_rate_ != 0.0)
+        {
+            status_parts.append(QString(trick_rate_ > 0.0 ? "快进 %1 关键帧" : "快退 %1 关键帧").arg(format_playback_rate_text(std::abs(trick_rate_))));
+        }
+        status_parts.append(reverse_playback_ ? QString("倒放") : clock_master_text(clock_->master()));
+        if (clock_->master() != clock_master::audio && audio_backend_ != nullptr)
+        {
+            status_parts.append(QString("音频漂移 %1 ms").arg(audio_backend_->audio_drift() * 1000.0, 0, 'f', 1));
+        }
+    }
+    if (demuxer_ != nullptr && demuxer_->last_seek_latency_ms() > 0.0)
+    {
+        status_parts.append(QString("跳转 %1 ms").arg(demuxer_->last_seek_latency_ms(), 0, 'f', 0));
+    }
+    lines.append(QString("<span style=\"color:#07c160; font-weight:600;\">状态</span> %1").arg(status_parts.join(" · ").toHtmlEscaped()));
+
+    if (audio_backend_ != nullptr)
+    {
+        const sdl_audio_backend::latency_calibration calibration = audio_backend_->calibration();
+        if (calibration.complete)
+        {
+            lines.append(QString("<span style=\"color:#07c160; font-weight:600;\">音频时钟</span> %1")
+                             .arg(QString("估计延迟 %1 ms · 周期 %2 ms · 抖动 %3 ms · 步进 %4 ms")
+                                      .arg(calibration.output_latency_ms, 0, 'f', 1)
+                                      .arg(calibration.measured_period_ms, 0, 'f', 2)
+                                      .arg(calibration.jitter_ms, 0, 'f', 2)
+                                      .arg(calibration.clock_step_ms, 0, 'f', 2)
+                                      .toHtmlEscaped()));
+        }
+    }
+
+    if (sync_thread_ != nullptr)
+    {
+        const present_histogram::snapshot present_stats = sync_thread_->present_errors().read();
+        if (present_stats.count > 0)
+        {
+            lines.append(QString("<span style=\"color:#07c160; font-weight:600;\">呈现</span> %1")
+                             .arg(QString("误差 p50 <%1 ms · p99 <%2 ms · 最大 %3 ms")
+                                      .arg(static_cast<double>(present_histogram::percentile_upper_us(present_stats, 0.5)) / 1000.0, 0, 'f', 2)
+                                      .arg(static_cast<double>(present_histogram::percentile_upper_us(present_stats, 0.99)) / 1000.0, 0, 'f', 2)
+                                      .arg(static_cast<double>(present_stats.max_error_us) / 1000.0, 0, 'f', 1)
+                                      .toHtmlEscaped()));
+        }
+    }
+
+    const vsync_pacer *pacer = video_widget_->pacer();
+    if (pacer->refresh_rate() > 0.0)
+    {
+        QStringList display_parts;
+        display_parts.append(QString("%1 Hz").arg(pacer->refresh_rate(), 0, 'f', 2));
+        display_parts.append(QString("丢失垂直同步 %1").arg(pacer->missed_vsyncs()));
+        lines.append(QString("<span style=\"color:#07c160; font-weight:600;\">显示</span> %1").arg(display_parts.join(" · ").toHtmlEscaped()));
+    }
+
+    const video_widget::render_stats render = video_widget_->render_timing();
+    if (render.paint.paints > 0)
+    {
+        const video_widget::upload_stats upload = video_widget_->upload_timing();
+        QStringList render_parts;
+        render_parts.append(QString("绘制 %1 ms · 峰值 %2 ms").arg(render.paint.average_us / 1000.0, 0, 'f', 2).arg(static_cast<double>(render.paint.peak_us) / 1000.0, 0, 'f', 2));
+        if (render.paint.gpu_timer)
+        {
+            render_parts.append(QString("GPU %1 ms").arg(render.paint.gpu_average_us / 1000.0, 0, 'f', 2));
+        }
+        if (upload.uploads > 0)
+        {
+            render_parts.append(QString("上传 %1 ms").arg(upload.average_us / 1000.0, 0, 'f', 2));
+        }
+        render_parts.append(QString("间隔 %1 ms · 峰值 %2 ms").arg(render.present_average_ms, 0, 'f', 2).arg(render.present_peak_ms, 0, 'f', 2));
+        lines.append(QString("<span style=\"color:#07c160; font-weight:600;\">渲染</span> %1").arg(render_parts.join(" · ").toHtmlEscaped()));
+        lines.append(QString("<span style=\"color:#07c160; font-weight:600;\">送显</span> %1")
+                         .arg(QString("接收 %1 · 绘制 %2 · 未绘制 %3").arg(render.received).arg(render.painted).arg(render.superseded).toHtmlEscaped()));
+    }
+
+    if (sync_thread_ != nullptr)
+    {
+        const video_sync_thread::frame_drop_stats drops = sync_thread_->frame_drops();
+        if (drops.stale + drops.late + drops.cadence > 0)
+        {
+            lines.append(QString("<span style=\"color:#07c160; font-weight:600;\">丢帧</span> %1")
+                             .arg(QString("延迟 %1 · 节奏 %2 · 过期 %3").arg(drops.late).arg(drops.cadence).arg(drops.stale).toHtmlEscaped()));
+        }
+
+        const video_scaler::stats scale = sync_thread_->scale_stats();
+        if (scale.conversions > 0)
+        {
+            lines.append(QString("<span style=\"color:#07c160; font-weight:600;\">缩放</span> %1")
+                             .arg(QString("线程 %1 · 平均 %2 ms · 峰值 %3 ms · 次数 %4")
+                                      .arg(scale.threads)
+                                      .arg(scale.average_us / 1000.0, 0, 'f', 2)
+                                      .arg(static_cast<double>(scale.max_us) / 1000.0, 0, 'f', 2)
+                                      .arg(scale.conversions)
+                                      .toHtmlEscaped()));
+        }
+
+        const frame_cache::stats cache = sync_thread_->cache_stats();
+        if (cache.frames > 0)
+        {
+            lines.append(QString("<span style=\"color:#07c160; font-weight:600;\">帧缓存</span> %1")
+                             .arg(QString("%1 帧 · %2 / %3 MiB · 命中 %4 · 淘汰 %5")
+                                      .arg(cache.frames)
+                                      .arg(static_cast<double>(cache.bytes) / (1024.0 * 1024.0), 0, 'f', 1)
+                                      .arg(static_cast<double>(cache.byte_budget) / (1024.0 * 1024.0), 0, 'f', 0)
+                                      .arg(cache.hits)
+                                      .arg(cache.evictions)
+                                      .toHtmlEscaped()));
+        }
+    }
 
     if (media_info_overlay_label_ == nullptr || media_info_overlay_ == nullptr)
     {
@@ -1832,6 +2018,8 @@ void main_window::update_media_info_overlay_geometry()
         const bool should_restore_visible = media_info_overlay_->isVisible();
         media_info_overlay_->setParent(container);
         media_info_overlay_->setAttribute(Qt::WA_StyledBackground, true);
+        media_info_overlay_->setAttribute(Qt::WA_DontCreateNativeAncestors, true);
+        media_info_overlay_->setAttribute(Qt::WA_NativeWindow, true);
         media_info_overlay_->setAttribute(Qt::WA_TransparentForMouseEvents);
         if (should_restore_visible)
         {
@@ -1875,7 +2063,7 @@ void main_window::show_shortcuts_help()
     dialog.setWindowFlags(Qt::Dialog | Qt::FramelessWindowHint);
     dialog.setModal(true);
     dialog.setWindowTitle("快捷键说明");
-    dialog.resize(520, 420);
+    dialog.resize(520, 522);
     dialog.setObjectName("shortcutsHelpDialog");
     dialog.setStyleSheet(load_stylesheet_resource(":/styles/shortcuts_help_dialog.qss"));
 
@@ -1908,7 +2096,7 @@ void main_window::show_shortcuts_help()
     body_layout->setContentsMargins(0, 0, 0, 0);
     body_layout->setSpacing(0);
 
-    auto *table = new QTableWidget(11, 2, body);
+    auto *table = new QTableWidget(14, 2, body);
     table->verticalHeader()->setVisible(false);
     table->horizontalHeader()->setVisible(false);
     table->horizontalHeader()->setStretchLastSection(true);
@@ -1930,6 +2118,9 @@ void main_window::show_shortcuts_help()
         {"?", "显示快捷键说明"},
         {"Space", "播放/暂停"},
         {"Left / Right", "快退 / 快进 5 秒"},
+        {", / .", "逐帧后退 / 前进"},
+        {"J", "倒放开关"},
+        {"[ / ]", "快退 / 快进 4x–32x"},
         {"Up / Down", "音量加 / 减"},
         {"F / F11", "切换全屏"},
         {"Esc", "退出全屏"}};
@@ -2131,6 +2322,7 @@ void main_window::show_playlist_context_menu(const QPoint &position)
 
 void main_window::set_playback_rate(double rate)
 {
+    stop_trick_play(true);
     const double normalized_rate = std::clamp(rate, 0.5, 2.0);
     if (std::abs(playback_rate_ - normalized_rate) < 0.0001)
     {
@@ -2897,10 +3089,18 @@ void main_window::on_toggle_pause()
         play_selected_playlist_item();
         return;
     }
+    stop_reverse_playback(true);
+    stop_trick_play(true);
     paused_ = !paused_;
 
     LOG_INFO("toggle pause state new state paused {}", paused_);
 
+    if (!paused_ && step_position_ >= 0.0)
+    {
+        LOG_INFO("resuming after frame step at {:.3f}", step_position_);
+        execute_seek(step_position_, true);
+    }
+
     btn_play_pause_->setIcon(QIcon(paused_ ? ":/icons/play.svg" : ":/icons/pause.svg"));
     btn_play_pause_->setToolTip(paused_ ? "播放" : "暂停");
 
@@ -2921,6 +3121,7 @@ void main_window::on_toggle_pause()
 void main_window::on_stop_pressed()
 {
     LOG_INFO("stop pressed");
+    discard_preroll();
     stop_play();
 
     slider_seek_->setValue(0);
@@ -3218,17 +3419,6 @@ void main_window::on_hardware_decode_toggled(bool checked)
     settings.setValue("playback/hardware_decode_enabled", hardware_decode_enabled_);
 }
 
-void main_window::on_video_frame_ready(std::shared_ptr<media_frame> frame)
-{
-    if (!playing_ || audio_only_mode_ || video_widget_ == nullptr)
-    {
-        return;
-    }
-
-    video_widget_->on_frame_ready(std::move(frame));
-    update_screenshot_button();
-}
-
 void main_window::on_volume_changed(int value)
 {
     update_volume_icon(value);
@@ -3267,6 +3457,8 @@ void main_window::do_seek_relative(double seconds)
 
 void main_window::request_seek(double target, bool deferred)
 {
+    stop_reverse_playback(false);
+    stop_trick_play(false);
     pending_seek_target_ = bounded_seek_target(target);
     update_seek_display(pending_seek_target_);
 
@@ -3283,16 +3475,17 @@ void main_window::request_seek(double target, bool deferred)
     {
         seek_commit_timer_->stop();
     }
-    execute_seek(pending_seek_target_);
+    execute_seek(pending_seek_target_, true);
 }
 
-void main_window::execute_seek(double target)
+void main_window::execute_seek(double target, bool precise)
 {
     if (demuxer_ == nullptr)
     {
         return;
     }
 
+    step_position_ = -1.0;
     target = bounded_seek_target(target);
     if (audio_backend_ != nullptr)
     {
@@ -3307,23 +3500,142 @@ void main_window::execute_seek(double target)
         audio_frame_queue_->clear();
     }
 
-    demuxer_->seek(target);
+    demuxer_->seek(target, precise);
     if (clock_ != nullptr)
     {
-        int seek_serial = clock_->serial();
-        if (audio_pkt_queue_ != nullptr && demuxer_->audio_index() >= 0)
-        {
-            seek_serial = audio_pkt_queue_->serial();
-        }
-        else if (video_pkt_queue_ != nullptr)
-        {
-            seek_serial = video_pkt_queue_->serial();
-        }
-        clock_->set(target, seek_serial);
+        clock_->set(target, seek_clock_serial());
     }
     update_seek_display(target);
 }
 
+int main_window::seek_clock_serial() const
+{
+    if (audio_pkt_queue_ != nullptr && demuxer_ != nullptr && demuxer_->audio_index() >= 0)
+    {
+        return audio_pkt_queue_->serial();
+    }
+    if (video_pkt_queue_ != nullptr)
+    {
+        return video_pkt_queue_->serial();
+    }
+    return clock_->serial();
+}
+
+void main_window::step_frame(int direction)
+{
+    if (!playing_ || audio_only_mode_ || sync_thread_ == nullptr)
+    {
+        return;
+    }
+
+    if (!paused_)
+    {
+        on_toggle_pause();
+    }
+    sync_thread_->request_step(direction);
+}
+
+void main_window::toggle_reverse_playback()
+{
+    if (reverse_playback_)
+    {
+        stop_reverse_playback(true);
+        return;
+    }
+    start_reverse_playback();
+}
+
+void main_window::start_reverse_playback()
+{
+    if (!playing_ || audio_only_mode_ || sync_thread_ == nullptr || demuxer_ == nullptr || clock_ == nullptr || reverse_playback_)
+    {
+        return;
+    }
+
+    stop_trick_play(true);
+    LOG_INFO("starting reverse playback at {:.3f}", clock_->get());
+    reverse_playback_ = true;
+    paused_ = false;
+    step_position_ = -1.0;
+    pending_seek_target_ = -1.0;
+    if (seek_commit_timer_ != nullptr)
+    {
+        seek_commit_timer_->stop();
+    }
+    btn_play_pause_->setIcon(QIcon(":/icons/pause.svg"));
+    btn_play_pause_->setToolTip("暂停");
+
+    demuxer_->set_audio_muted(true);
+    if (audio_backend_ != nullptr)
+    {
+        audio_backend_->pause(true);
+        audio_backend_->flush();
+    }
+    if (audio_frame_queue_ != nullptr)
+    {
+        audio_frame_queue_->clear();
+    }
+    clock_->set_master(clock_master::video);
+    clock_->pause();
+
+    sync_thread_->set_reverse(true);
+    sync_thread_->paused(false);
+    update_media_info_overlay();
+}
+
+void main_window::stop_reverse_playback(bool seek_to_current)
+{
+    if (!reverse_playback_)
+    {
+        return;
+    }
+
+    reverse_playback_ = false;
+    if (sync_thread_ != nullptr)
+    {
+        sync_thread_->set_reverse(false);
+    }
+    if (demuxer_ != nullptr)
+    {
+        demuxer_->set_audio_muted(false);
+    }
+
+    const double position = clock_ != nullptr ? clock_->get() : 0.0;
+    LOG_INFO("stopping reverse playback at {:.3f}", position);
+    if (clock_ != nullptr)
+    {
+        clock_->set_master(playback_master_);
+    }
+    if (seek_to_current)
+    {
+        execute_seek(position, true);
+    }
+    if (clock_ != nullptr && !paused_)
+    {
+        clock_->resume();
+    }
+    if (audio_backend_ != nullptr)
+    {
+        audio_backend_->pause(paused_);
+    }
+    update_media_info_overlay();
+}
+
+void main_window::on_step_cache_miss(double pts)
+{
+    if (demuxer_ == nullptr || sync_thread_ == nullptr || !paused_)
+    {
+        return;
+    }
+
+    const AVRational frame_rate = demuxer_->frame_rate(demuxer_->video_index());
+    const double frame_duration = frame_rate.num > 0 && frame_rate.den > 0 ? av_q2d(av_inv_q(frame_rate)) : 0.04;
+    const double target = std::max(0.0, pts - (frame_duration * 0.5));
+    LOG_INFO("frame step backward from {:.3f} not cached seeking to {:.3f}", pts, target);
+    execute_seek(target, true);
+    sync_thread_->request_step_to(target);
+}
+
 void main_window::update_seek_display(double target)
 {
     if (slider_seek_ != nullptr)
@@ -3366,6 +3678,115 @@ void main_window::on_slider_released()
     }
 }
 
+void main_window::cycle_trick_play(int direction)
+{
+    const double sign = direction > 0 ? 1.0 : -1.0;
+    double next = 4.0 * sign;
+    if (trick_rate_ * sign > 0.0)
+    {
+        next = trick_rate_ * 2.0;
+        if (std::abs(next) > k_max_trick_rate)
+        {
+            stop_trick_play(true);
+            update_playback_rate_button();
+            return;
+        }
+    }
+    start_trick_play(next);
+}
+
+void main_window::start_trick_play(double rate)
+{
+    if (!playing_ || audio_only_mode_ || sync_thread_ == nullptr || demuxer_ == nullptr || clock_ == nullptr || video_decoder_ == nullptr)
+    {
+        update_playback_rate_button();
+        return;
+    }
+
+    stop_reverse_playback(false);
+    const double position = clock_->get();
+    const bool reseek = trick_rate_ * rate <= 0.0;
+    LOG_INFO("starting trick play {}x at {:.3f}", rate, position);
+    trick_rate_ = rate;
+    paused_ = false;
+    step_position_ = -1.0;
+    pending_seek_target_ = -1.0;
+    if (seek_commit_timer_ != nullptr)
+    {
+        seek_commit_timer_->stop();
+    }
+    btn_play_pause_->setIcon(QIcon(":/icons/pause.svg"));
+    btn_play_pause_->setToolTip("暂停");
+
+    demuxer_->set_audio_muted(true);
+    demuxer_->set_trick_rate(rate);
+    video_decoder_->set_skip_nonkey(true);
+    if (audio_backend_ != nullptr)
+    {
+        audio_backend_->pause(true);
+        audio_backend_->flush();
+    }
+    if (audio_frame_queue_ != nullptr)
+    {
+        audio_frame_queue_->clear();
+    }
+    clock_->set_master(clock_master::external);
+    clock_->pause();
+
+    sync_thread_->set_trick_rate(rate);
+    sync_thread_->paused(false);
+    if (reseek)
+    {
+        execute_seek(position, false);
+    }
+    update_playback_rate_button();
+    update_media_info_overlay();
+}
+
+void main_window::stop_trick_play(bool seek_to_current)
+{
+    if (trick_rate_ == 0.0)
+    {
+        return;
+    }
+
+    trick_rate_ = 0.0;
+    if (sync_thread_ != nullptr)
+    {
+        sync_thread_->set_trick_rate(0.0);
+    }
+    if (video_decoder_ != nullptr)
+    {
+        video_decoder_->set_skip_nonkey(false);
+    }
+    if (demuxer_ != nullptr)
+    {
+        demuxer_->set_trick_rate(0.0);
+        demuxer_->set_audio_muted(false);
+    }
+
+    const double position = clock_ != nullptr ? clock_->get() : 0.0;
+    LOG_INFO("stopping trick play at {:.3f}", position);
+    if (clock_ != nullptr)
+    {
+        clock_->set_master(playback_master_);
+    }
+    if (seek_to_current)
+    {
+        execute_seek(position, true);
+    }
+    if (clock_ != nullptr && !paused_)
+    {
+        clock_->resume();
+    }
+    if (audio_backend_ != nullptr)
+    {
+        audio_backend_->pause(paused_);
+    }
+    update_playback_rate_button();
+    update_media_info_overlay();
+}
+
 void main_window::on_update_ui()
 {
     if (!playing_ || clock_ == nullptr)
@@ -3382,6 +3803,22 @@ void main_window::on_update_ui()
         return;
     }
 
+    if (trick_rate_ < 0.0 && demuxer_ != nullptr && demuxer_->trick_boundary_reached() && video_frame_queue_ != nullptr && video_frame_queue_->empty())
+    {
+        LOG_INFO("trick rewind reached start");
+        on_toggle_pause();
+        return;
+    }
+    if (trick_rate_ > 0.0 && demuxer_ != nullptr && demuxer_->eof_reached() && video_pkt_queue_ != nullptr && video_pkt_queue_->empty() &&
+        video_frame_queue_ != nullptr && video_frame_queue_->empty())
+    {
+        LOG_INFO("trick forward reached end");
+        finish_playback();
+        return;
+    }
+
+    update_preroll(current);
+
     if (!slider_seek_->isSliderDown())
     {
         slider_seek_->setValue(static_cast<int>(current));
@@ -3389,6 +3826,11 @@ void main_window::on_update_ui()
 
     lbl_time_->setText(QString("%1 / %2").arg(format_time(current), format_time(duration_)));
     save_current_playback_progress();
+    update_screenshot_button();
+    if (media_info_overlay_enabled_)
+    {
+        update_media_info_overlay();
+    }
 }
 
 void main_window::play_playlist_item(const QString &playlist_id, int row, bool allow_resume_prompt)
@@ -3405,10 +3847,20 @@ void main_window::play_playlist_item(const QString &playlist_id, int row, bool a
         return;
     }
 
-    stop_play();
+    const bool use_preroll = preroll_ != nullptr && preroll_->matches(playlist_id, row, path.toStdString());
+    if (!use_preroll)
+    {
+        discard_preroll();
+    }
+
+    stop_play(use_preroll);
     if (!start_play(path.toStdString()))
     {
         LOG_ERROR("failed to start play for {}", path.toStdString());
+        if (video_widget_ != nullptr)
+        {
+            video_widget_->clear();
+        }
         QMessageBox::critical(this, "错误", "打开媒体文件失败");
         return;
     }
@@ -3476,6 +3928,7 @@ void main_window::finish_playback()
     }
 
     LOG_INFO("playback reached end resetting ui");
+    discard_preroll();
     stop_play();
 
     const int end_value = qMax(0, static_cast<int>(duration_));
@@ -3486,9 +3939,9 @@ void main_window::finish_playback()
     btn_play_pause_->setToolTip("播放");
 }
 
-void main_window::stop_play()
+void main_window::stop_play(bool keep_last_frame)
 {
-    if (!playing_)
+    if (!playing_ && !demux_thread_.joinable())
     {
         return;
     }
@@ -3498,6 +3951,8 @@ void main_window::stop_play()
 
     playing_ = false;
     paused_ = false;
+    reverse_playback_ = false;
+    trick_rate_ = 0.0;
     ui_timer_->stop();
 
     LOG_INFO("aborting queues");
@@ -3577,7 +4032,10 @@ void main_window::stop_play()
     if (video_widget_ != nullptr)
     {
         QCoreApplication::removePostedEvents(video_widget_, QEvent::MetaCall);
-        video_widget_->clear();
+        if (!keep_last_frame)
+        {
+            video_widget_->clear();
+        }
     }
     current_media_path_.clear();
     current_playback_playlist_id_.clear();
@@ -3606,42 +4064,74 @@ bool main_window::start_play(const std::string &filepath)
 {
     LOG_INFO("starting play for file {}", filepath);
     const uint64_t playback_generation = ++playback_generation_;
-    video_pkt_queue_ = std::make_unique<safe_queue<std::shared_ptr<media_packet>>>(100);
-    audio_pkt_queue_ = std::make_unique<safe_queue<std::shared_ptr<media_packet>>>(100);
-    video_frame_queue_ = std::make_unique<safe_queue<std::shared_ptr<media_frame>>>(16);
-    audio_frame_queue_ = std::make_unique<safe_queue<std::shared_ptr<media_frame>>>(64);
+    const bool prerolled = preroll_ != nullptr && preroll_->ready() && preroll_->url() == filepath;
 
     clock_ = std::make_unique<av_clock>();
     clock_->set_rate(playback_rate_);
 
-    demuxer_ = std::make_unique<demuxer>();
-    if (!demuxer_->open(filepath, video_pkt_queue_.get(), audio_pkt_queue_.get()))
+    if (prerolled)
     {
-        LOG_ERROR("failed to open demuxer");
-        return false;
+        adopt_preroll_pipeline();
     }
-    LOG_INFO("demuxer opened");
+    else
+    {
+        discard_preroll();
+        video_pkt_queue_ = std::make_unique<safe_queue<std::shared_ptr<media_packet>>>(100);
+        audio_pkt_queue_ = std::make_unique<safe_queue<std::shared_ptr<media_packet>>>(100);
+        video_frame_queue_ = std::make_unique<safe_queue<std::shared_ptr<media_frame>>>(16);
+        audio_frame_queue_ = std::make_unique<safe_queue<std::shared_ptr<media_frame>>>(64);
 
+        demuxer_ = std::make_unique<demuxer>();
+        if (!demuxer_->open(filepath, video_pkt_queue_.get(), audio_pkt_queue_.get()))
+        {
+            LOG_ERROR("failed to open demuxer");
+            return false;
+        }
+        LOG_INFO("demuxer opened");
+    }
+
+    demuxer *seek_demuxer = demuxer_.get();
+    av_clock *seek_clock = clock_.get();
+    const safe_queue<std::shared_ptr<media_packet>> *seek_serial_queue =
+        demuxer_->audio_index() >= 0 ? audio_pkt_queue_.get() : video_pkt_queue_.get();
     demuxer_->set_seek_cb(
-        [this](double time)
+        [this, seek_demuxer, seek_clock, seek_serial_queue, playback_generation](double target, double landed)
         {
+            if (!seek_demuxer->seek_pending() && landed != target)
+            {
+                seek_clock->set(landed, seek_serial_queue->serial());
+            }
             QMetaObject::invokeMethod(this,
-                                      [this, time]()
+                                      [this, target, landed, playback_generation]()
                                       {
-                                          LOG_INFO("UI received seek finish callback time {}", time);
-                                          if (pending_seek_target_ >= 0.0 && std::abs(pending_seek_target_ - time) > 0.5)
+                                          LOG_INFO("UI received seek finish callback target {} landed {:.3f}", target, landed);
+                                          if (playback_generation != playback_generation_ || reverse_playback_)
+                                          {
+                                              return;
+                                          }
+                                          if (pending_seek_target_ >= 0.0 && std::abs(pending_seek_target_ - target) > 0.5)
                                           {
                                               return;
                                           }
                                           pending_seek_target_ = -1.0;
                                           if (!slider_seek_->isSliderDown())
                                           {
-                                              slider_seek_->setValue(static_cast<int>(time));
-                                              lbl_time_->setText(QString("%1 / %2").arg(format_time(time), format_time(duration_)));
+                                              slider_seek_->setValue(static_cast<int>(landed));
+                                              lbl_time_->setText(QString("%1 / %2").arg(format_time(landed), format_time(duration_)));
                                           }
+                                          update_media_info_overlay();
                                       });
         });
 
+    clock_master master = clock_master::video;
+    if (demuxer_->audio_index() >= 0)
+    {
+        master = demuxer_->realtime() ? clock_master::external : clock_master::audio;
+    }
+    LOG_INFO("clock master selected {}", clock_master_text(master).toStdString());
+    clock_->set_master(master);
+    playback_master_ = master;
+
     duration_ = demuxer_->duration();
     last_saved_progress_second_ = -1;
     pending_seek_target_ = -1.0;
@@ -3654,10 +4144,13 @@ bool main_window::start_play(const std::string &filepath)
     slider_seek_->setValue(0);
     lbl_time_->setText(QString("%1 / %2").arg(format_time(0.0), format_time(duration_)));
 
-    video_decoder_ = std::make_unique<decoder>();
-    audio_decoder_ = std::make_unique<decoder>();
+    if (!prerolled)
+    {
+        video_decoder_ = std::make_unique<decoder>();
+        audio_decoder_ = std::make_unique<decoder>();
+    }
 
-    if (demuxer_->video_index() >= 0)
+    if (!prerolled && demuxer_->video_index() >= 0)
     {
         LOG_INFO("video stream found index {}", demuxer_->video_index());
         if (!video_decoder_->open(demuxer_->codec_par(demuxer_->video_index()),
@@ -3671,7 +4164,7 @@ bool main_window::start_play(const std::string &filepath)
         }
     }
 
-    if (demuxer_->audio_index() >= 0)
+    if (!prerolled && demuxer_->audio_index() >= 0)
     {
         LOG_INFO("audio stream found index {}", demuxer_->audio_index());
         if (!audio_decoder_->open(demuxer_->codec_par(demuxer_->audio_index()), audio_pkt_queue_.get(), audio_frame_queue_.get(), "Audio"))
@@ -3697,46 +4190,101 @@ bool main_window::start_play(const std::string &filepath)
     {
         sync_thread_ = std::make_unique<video_sync_thread>(
             video_frame_queue_.get(), video_pkt_queue_.get(), demuxer_->time_base(demuxer_->video_index()), clock_.get());
+        sync_thread_->set_vsync_pacer(video_widget_ != nullptr ? video_widget_->pacer() : nullptr);
+        if (video_widget_ != nullptr)
+        {
+            sync_thread_->set_display_size(video_widget_->drawable_size().width(), video_widget_->drawable_size().height());
+        }
+
+        connect(
+            sync_thread_.get(),
+            &video_sync_thread::frame_ready,
+            this,
+            [this](const std::shared_ptr<media_frame> &frame)
+            {
+                if (!audio_only_mode_ && video_widget_ != nullptr)
+                {
+                    video_widget_->submit_frame(frame);
+                }
+            },
+            Qt::DirectConnection);
+        connect(sync_thread_.get(),
+                &video_sync_thread::stepped,
+                this,
+                [this, playback_generation](double pts)
+                {
+                    if (playback_generation != playback_generation_)
+                    {
+                        return;
+                    }
 
+                    step_position_ = pts;
+                    update_seek_display(pts);
+                });
         connect(sync_thread_.get(),
-                &video_sync_thread::frame_ready,
+                &video_sync_thread::step_cache_miss,
                 this,
-                [this, playback_generation](std::shared_ptr<media_frame> frame)
+                [this, playback_generation](double pts)
                 {
                     if (playback_generation != playback_generation_)
                     {
                         return;
                     }
 
-                    on_video_frame_ready(std::move(frame));
+                    on_step_cache_miss(pts);
+                });
+        connect(sync_thread_.get(),
+                &video_sync_thread::reverse_reached_start,
+                this,
+                [this, playback_generation]()
+                {
+                    if (playback_generation != playback_generation_ || !reverse_playback_)
+                    {
+                        return;
+                    }
+
+                    LOG_INFO("reverse playback reached start pausing");
+                    on_toggle_pause();
                 });
+        sync_thread_->set_reverse_seek_handler(
+            [this](double target)
+            {
+                demuxer_->seek(target, true);
+                video_frame_queue_->clear();
+            });
 
         sync_thread_->start();
     }
 
-    LOG_INFO("starting threads");
-    demux_thread_ = std::thread([this]() { demuxer_->run(); });
+    if (!prerolled)
+    {
+        LOG_INFO("starting threads");
+        demux_thread_ = std::thread([this]() { demuxer_->run(); });
 
-    video_decoder_thread_ = std::thread(
-        [this]()
-        {
-            if (demuxer_->video_index() >= 0)
+        video_decoder_thread_ = std::thread(
+            [this]()
             {
-                video_decoder_->run();
-            }
-        });
+                if (demuxer_->video_index() >= 0)
+                {
+                    video_decoder_->run();
+                }
+            });
 
-    audio_decoder_thread_ = std::thread(
-        [this]()
-        {
-            if (demuxer_->audio_index() >= 0)
+        audio_decoder_thread_ = std::thread(
+            [this]()
             {
-                audio_decoder_->run();
-            }
-        });
+                if (demuxer_->audio_index() >= 0)
+                {
+                    audio_decoder_->run();
+                }
+            });
+    }
 
     playing_ = true;
     paused_ = false;
+    reverse_playback_ = false;
+    trick_rate_ = 0.0;
+    step_position_ = -1.0;
     btn_play_pause_->setIcon(QIcon(":/icons/pause.svg"));
     btn_play_pause_->setToolTip("暂停");
     ui_timer_->start();
@@ -3749,3 +4297,67 @@ bool main_window::start_play(const std::string &filepath)
 
     return true;
 }
+
+void main_window::adopt_preroll_pipeline()
+{
+    LOG_INFO("adopting prerolled pipeline for {}", preroll_->url());
+    media_preroll::pipeline prerolled = preroll_->release();
+    preroll_.reset();
+
+    video_pkt_queue_ = std::move(prerolled.video_pkt_queue);
+    audio_pkt_queue_ = std::move(prerolled.audio_pkt_queue);
+    video_frame_queue_ = std::move(prerolled.video_frame_queue);
+    audio_frame_queue_ = std::move(prerolled.audio_frame_queue);
+    demuxer_ = std::move(prerolled.demux);
+    video_decoder_ = std::move(prerolled.video_decoder);
+    audio_decoder_ = std::move(prerolled.audio_decoder);
+    demux_thread_ = std::move(prerolled.demux_thread);
+    video_decoder_thread_ = std::move(prerolled.video_decoder_thread);
+    audio_decoder_thread_ = std::move(prerolled.audio_decoder_thread);
+}
+
+void main_window::update_preroll(double current)
+{
+    if (btn_sequential_playback_ == nullptr || !btn_sequential_playback_->isChecked())
+    {
+        discard_preroll();
+        return;
+    }
+
+    const bool near_end = (demuxer_ != nullptr && demuxer_->eof_reached()) || (duration_ > 0.0 && current >= duration_ - k_preroll_lead_second);
+    if (!near_end)
+    {
+        discard_preroll();
+        return;
+    }
+
+    const QString playlist_id = playback_playlist_id();
+    const playlist_entry *entry = playlist_store_.playlist_by_id(playlist_id);
+    const int next_row = playback_playlist_row() + 1;
+    if (entry == nullptr || next_row <= 0 || next_row >= entry->paths.size() || entry->paths[next_row].isEmpty())
+    {
+        discard_preroll();
+        return;
+    }
+
+    const std::string next_path = entry->paths[next_row].toStdString();
+    if (preroll_ != nullptr && preroll_->matches(playlist_id, next_row, next_path))
+    {
+        return;
+    }
+
+    discard_preroll();
+    preroll_ = std::make_unique<media_preroll>();
+    preroll_->start(playlist_id, next_row, next_path, hardware_decode_enabled_);
+}
+
+void main_window::discard_preroll()
+{
+    if (preroll_ == nullptr)
+    {
+        return;
+    }
+
+    LOG_INFO("discarding preroll for {}", preroll_->url());
+    preroll_.reset();
+}
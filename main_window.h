@@ -20,6 +20,7 @@
 #include <QResizeEvent>
 #include <Qt>
 #include <QString>
+#include <atomic>
 #include <cstdint>
 #include <thread>
 #include <memory>
@@ -34,6 +35,7 @@
 #include "sdl_audio_backend.h"
 #include "video_sync_thread.h"
 #include "playlist_store.h"
+#include "media_preroll.h"
 
 class QMenu;
 class QWidget;
@@ -72,17 +74,28 @@ class main_window : public QMainWindow
     void on_playlist_item_activated(QTreeWidgetItem *item, int column);
     void on_audio_only_toggled(bool checked);
     void on_hardware_decode_toggled(bool checked);
-    void on_video_frame_ready(std::shared_ptr<media_frame> frame);
     void on_create_playlist();
 
    private:
-    void stop_play();
+    void stop_play(bool keep_last_frame = false);
     bool start_play(const std::string &filepath);
+    void adopt_preroll_pipeline();
+    void update_preroll(double current);
+    void discard_preroll();
     void open_files_into_playlist(const QString &playlist_id);
     void open_files_into_playlist(const QString &playlist_id, const QStringList &filenames);
     void do_seek_relative(double seconds);
     void request_seek(double target, bool deferred);
-    void execute_seek(double target);
+    void execute_seek(double target, bool precise);
+    [[nodiscard]] int seek_clock_serial() const;
+    void step_frame(int direction);
+    void toggle_reverse_playback();
+    void start_reverse_playback();
+    void stop_reverse_playback(bool seek_to_current);
+    void cycle_trick_play(int direction);
+    void start_trick_play(double rate);
+    void stop_trick_play(bool seek_to_current);
+    void on_step_cache_miss(double pts);
     void update_seek_display(double target);
     [[nodiscard]] double bounded_seek_target(double target) const;
     void init_styles();
@@ -224,13 +237,17 @@ class main_window : public QMainWindow
     uint64_t playback_generation_ = 0;
     double playback_rate_ = 1.0;
     double pending_seek_target_ = -1.0;
-    bool audio_only_mode_ = false;
+    double step_position_ = -1.0;
+    std::atomic<bool> audio_only_mode_{false};
     bool hardware_decode_enabled_ = false;
     bool media_info_overlay_enabled_ = false;
     playlist_store playlist_store_;
 
     bool playing_ = false;
     bool paused_ = false;
+    bool reverse_playback_ = false;
+    clock_master playback_master_ = clock_master::audio;
+    double trick_rate_ = 0.0;
     double duration_ = 0.0;
     std::thread demux_thread_;
     std::thread video_decoder_thread_;
@@ -245,6 +262,7 @@ class main_window : public QMainWindow
     std::unique_ptr<safe_queue<std::shared_ptr<media_packet>>> audio_pkt_queue_;
     std::unique_ptr<safe_queue<std::shared_ptr<media_frame>>> video_frame_queue_;
     std::unique_ptr<safe_queue<std::shared_ptr<media_frame>>> audio_frame_queue_;
+    std::unique_ptr<media_preroll> preroll_;
 };
 
 #endif
@@ -0,0 +1,147 @@
+#include "media_preroll.h"
+#include "log.h"
+
+media_preroll::~media_preroll()
+{
+    LOG_INFO("media preroll destroying url {}", url_);
+    stop();
+}
+
+void media_preroll::start(const QString &playlist_id, int row, const std::string &url, bool try_hardware_decode)
+{
+    LOG_INFO("media preroll starting row {} url {}", row, url);
+    playlist_id_ = playlist_id;
+    row_ = row;
+    url_ = url;
+    cancelled_.store(false);
+    ready_.store(false);
+    failed_.store(false);
+
+    pipeline_.video_pkt_queue = std::make_unique<safe_queue<std::shared_ptr<media_packet>>>(100);
+    pipeline_.audio_pkt_queue = std::make_unique<safe_queue<std::shared_ptr<media_packet>>>(100);
+    pipeline_.video_frame_queue = std::make_unique<safe_queue<std::shared_ptr<media_frame>>>(16);
+    pipeline_.audio_frame_queue = std::make_unique<safe_queue<std::shared_ptr<media_frame>>>(64);
+    pipeline_.demux = std::make_unique<demuxer>();
+    pipeline_.video_decoder = std::make_unique<decoder>();
+    pipeline_.audio_decoder = std::make_unique<decoder>();
+
+    pipeline_.demux_thread = std::thread([this, try_hardware_decode]() { open_and_run(try_hardware_decode); });
+}
+
+void media_preroll::open_and_run(bool try_hardware_decode)
+{
+    demuxer *demux = pipeline_.demux.get();
+    if (!demux->open(url_, pipeline_.video_pkt_queue.get(), pipeline_.audio_pkt_queue.get()) || cancelled_.load())
+    {
+        LOG_WARN("media preroll open demuxer failed or cancelled url {}", url_);
+        failed_.store(true);
+        return;
+    }
+
+    if (demux->video_index() >= 0 && !pipeline_.video_decoder->open(demux->codec_par(demux->video_index()),
+                                                                     pipeline_.video_pkt_queue.get(),
+                                                                     pipeline_.video_frame_queue.get(),
+                                                                     "Video",
+                                                                     try_hardware_decode))
+    {
+        LOG_WARN("media preroll open video decoder failed url {}", url_);
+        failed_.store(true);
+        return;
+    }
+
+    if (demux->audio_index() >= 0 && !pipeline_.audio_decoder->open(demux->codec_par(demux->audio_index()),
+                                                                     pipeline_.audio_pkt_queue.get(),
+                                                                     pipeline_.audio_frame_queue.get(),
+                                                                     "Audio"))
+    {
+        LOG_WARN("media preroll open audio decoder failed url {}", url_);
+        failed_.store(true);
+        return;
+    }
+
+    if (cancelled_.load())
+    {
+        failed_.store(true);
+        return;
+    }
+
+    if (demux->video_index() >= 0)
+    {
+        pipeline_.video_decoder_thread = std::thread([video_decoder = pipeline_.video_decoder.get()]() { video_decoder->run(); });
+    }
+    if (demux->audio_index() >= 0)
+    {
+        pipeline_.audio_decoder_thread = std::thread([audio_decoder = pipeline_.audio_decoder.get()]() { audio_decoder->run(); });
+    }
+
+    LOG_INFO("media preroll ready url {}", url_);
+    ready_.store(true);
+    demux->run();
+}
+
+void media_preroll::stop()
+{
+    cancelled_.store(true);
+    if (pipeline_.demux != nullptr)
+    {
+        pipeline_.demux->stop();
+    }
+    if (pipeline_.video_pkt_queue != nullptr)
+    {
+        pipeline_.video_pkt_queue->abort();
+    }
+    if (pipeline_.audio_pkt_queue != nullptr)
+    {
+        pipeline_.audio_pkt_queue->abort();
+    }
+    if (pipeline_.demux_thread.joinable())
+    {
+        pipeline_.demux_thread.join();
+    }
+
+    if (pipeline_.video_decoder != nullptr)
+    {
+        pipeline_.video_decoder->stop();
+    }
+    if (pipeline_.audio_decoder != nullptr)
+    {
+        pipeline_.audio_decoder->stop();
+    }
+    if (pipeline_.video_frame_queue != nullptr)
+    {
+        pipeline_.video_frame_queue->abort();
+    }
+    if (pipeline_.audio_frame_queue != nullptr)
+    {
+        pipeline_.audio_frame_queue->abort();
+    }
+    if (pipeline_.video_decoder_thread.joinable())
+    {
+        pipeline_.video_decoder_thread.join();
+    }
+    if (pipeline_.audio_decoder_thread.joinable())
+    {
+        pipeline_.audio_decoder_thread.join();
+    }
+
+    pipeline_ = pipeline{};
+    ready_.store(false);
+}
+
+bool media_preroll::ready() const { return ready_.load(); }
+
+bool media_preroll::failed() const { return failed_.load(); }
+
+bool media_preroll::matches(const QString &playlist_id, int row, const std::string &url) const
+{
+    return playlist_id_ == playlist_id && row_ == row && url_ == url;
+}
+
+const std::string &media_preroll::url() const { return url_; }
+
+media_preroll::pipeline media_preroll::release()
+{
+    LOG_INFO("media preroll releasing pipeline url {}", url_);
+    ready_.store(false);
+    return std::move(pipeline_);
+}
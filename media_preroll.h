@@ -0,0 +1,59 @@
+#ifndef MEDIA_PREROLL_H
+#define MEDIA_PREROLL_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <QString>
+#include "demuxer.h"
+#include "decoder.h"
+#include "safe_queue.h"
+#include "media_objects.h"
+
+class media_preroll
+{
+   public:
+    struct pipeline
+    {
+        std::unique_ptr<safe_queue<std::shared_ptr<media_packet>>> video_pkt_queue;
+        std::unique_ptr<safe_queue<std::shared_ptr<media_packet>>> audio_pkt_queue;
+        std::unique_ptr<safe_queue<std::shared_ptr<media_frame>>> video_frame_queue;
+        std::unique_ptr<safe_queue<std::shared_ptr<media_frame>>> audio_frame_queue;
+        std::unique_ptr<demuxer> demux;
+        std::unique_ptr<decoder> video_decoder;
+        std::unique_ptr<decoder> audio_decoder;
+        std::thread demux_thread;
+        std::thread video_decoder_thread;
+        std::thread audio_decoder_thread;
+    };
+
+   public:
+    media_preroll() = default;
+    ~media_preroll();
+    media_preroll(const media_preroll &) = delete;
+    media_preroll &operator=(const media_preroll &) = delete;
+
+   public:
+    void start(const QString &playlist_id, int row, const std::string &url, bool try_hardware_decode);
+    void stop();
+    [[nodiscard]] bool ready() const;
+    [[nodiscard]] bool failed() const;
+    [[nodiscard]] bool matches(const QString &playlist_id, int row, const std::string &url) const;
+    [[nodiscard]] const std::string &url() const;
+    pipeline release();
+
+   private:
+    void open_and_run(bool try_hardware_decode);
+
+   private:
+    QString playlist_id_;
+    int row_ = -1;
+    std::string url_;
+    pipeline pipeline_;
+    std::atomic<bool> cancelled_{false};
+    std::atomic<bool> ready_{false};
+    std::atomic<bool> failed_{false};
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef PRESENT_HISTOGRAM_H
+#define PRESENT_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+class present_histogram
+{
+   public:
+    static constexpr size_t k_bucket_count = 8;
+    static constexpr std::array<int64_t, k_bucket_count - 1> k_bucket_upper_us = {250, 500, 1000, 2000, 4000, 8000, 16000};
+
+    struct snapshot
+    {
+        std::array<uint64_t, k_bucket_count> buckets{};
+        uint64_t count = 0;
+        int64_t max_error_us = 0;
+        double mean_error_us = 0.0;
+    };
+
+   public:
+    void record(int64_t error_us)
+    {
+        const int64_t magnitude = std::abs(error_us);
+        size_t bucket = 0;
+        while (bucket < k_bucket_upper_us.size() && magnitude >= k_bucket_upper_us[bucket])
+        {
+            ++bucket;
+        }
+
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        total_error_us_.fetch_add(magnitude, std::memory_order_relaxed);
+
+        int64_t current_max = max_error_us_.load(std::memory_order_relaxed);
+        while (magnitude > current_max && !max_error_us_.compare_exchange_weak(current_max, magnitude, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void reset()
+    {
+        for (auto &bucket : buckets_)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        total_error_us_.store(0, std::memory_order_relaxed);
+        max_error_us_.store(0, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] snapshot read() const
+    {
+        snapshot s;
+        for (size_t i = 0; i < k_bucket_count; ++i)
+        {
+            s.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        }
+        s.count = count_.load(std::memory_order_relaxed);
+        s.max_error_us = max_error_us_.load(std::memory_order_relaxed);
+        if (s.count > 0)
+        {
+            s.mean_error_us = static_cast<double>(total_error_us_.load(std::memory_order_relaxed)) / static_cast<double>(s.count);
+        }
+        return s;
+    }
+
+    [[nodiscard]] static int64_t percentile_upper_us(const snapshot &s, double fraction)
+    {
+        if (s.count == 0)
+        {
+            return 0;
+        }
+
+        const auto wanted = static_cast<uint64_t>(std::ceil(static_cast<double>(s.count) * fraction));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < k_bucket_upper_us.size(); ++i)
+        {
+            seen += s.buckets[i];
+            if (seen >= wanted)
+            {
+                return k_bucket_upper_us[i];
+            }
+        }
+        return s.max_error_us;
+    }
+
+   private:
+    std::array<std::atomic<uint64_t>, k_bucket_count> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<int64_t> total_error_us_{0};
+    std::atomic<int64_t> max_error_us_{0};
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "render_format.h"
+
+namespace
+{
+constexpr render_plane k_luma8{1, 1, 0, 0};
+constexpr render_plane k_luma16{1, 2, 0, 0};
+constexpr render_plane k_chroma420{1, 1, 1, 1};
+constexpr render_plane k_chroma422{1, 1, 1, 0};
+constexpr render_plane k_chroma444{1, 1, 0, 0};
+constexpr render_plane k_chroma420_16{1, 2, 1, 1};
+constexpr render_plane k_chroma422_16{1, 2, 1, 0};
+constexpr render_plane k_chroma444_16{1, 2, 0, 0};
+constexpr render_plane k_interleaved420{2, 1, 1, 1};
+constexpr render_plane k_interleaved420_16{2, 2, 1, 1};
+constexpr render_plane k_packed_rgba{4, 1, 0, 0};
+
+constexpr render_format k_render_formats[] = {
+    {AV_PIX_FMT_YUV420P, render_shader::planar_yuv, 3, {k_luma8, k_chroma420, k_chroma420}},
+    {AV_PIX_FMT_YUVJ420P, render_shader::planar_yuv, 3, {k_luma8, k_chroma420, k_chroma420}},
+    {AV_PIX_FMT_YUV422P, render_shader::planar_yuv, 3, {k_luma8, k_chroma422, k_chroma422}},
+    {AV_PIX_FMT_YUVJ422P, render_shader::planar_yuv, 3, {k_luma8, k_chroma422, k_chroma422}},
+    {AV_PIX_FMT_YUV444P, render_shader::planar_yuv, 3, {k_luma8, k_chroma444, k_chroma444}},
+    {AV_PIX_FMT_YUVJ444P, render_shader::planar_yuv, 3, {k_luma8, k_chroma444, k_chroma444}},
+    {AV_PIX_FMT_YUV420P10LE, render_shader::planar_yuv, 3, {k_luma16, k_chroma420_16, k_chroma420_16}, 10, 0},
+    {AV_PIX_FMT_YUV422P10LE, render_shader::planar_yuv, 3, {k_luma16, k_chroma422_16, k_chroma422_16}, 10, 0},
+    {AV_PIX_FMT_YUV444P10LE, render_shader::planar_yuv, 3, {k_luma16, k_chroma444_16, k_chroma444_16}, 10, 0},
+    {AV_PIX_FMT_YUV420P12LE, render_shader::planar_yuv, 3, {k_luma16, k_chroma420_16, k_chroma420_16}, 12, 0},
+    {AV_PIX_FMT_YUV422P12LE, render_shader::planar_yuv, 3, {k_luma16, k_chroma422_16, k_chroma422_16}, 12, 0},
+    {AV_PIX_FMT_YUV444P12LE, render_shader::planar_yuv, 3, {k_luma16, k_chroma444_16, k_chroma444_16}, 12, 0},
+    {AV_PIX_FMT_NV12, render_shader::semi_planar_yuv, 2, {k_luma8, k_interleaved420, {}}},
+    {AV_PIX_FMT_NV21, render_shader::semi_planar_yvu, 2, {k_luma8, k_interleaved420, {}}},
+    {AV_PIX_FMT_P010LE, render_shader::semi_planar_yuv, 2, {k_luma16, k_interleaved420_16, {}}, 10, 6},
+    {AV_PIX_FMT_P016LE, render_shader::semi_planar_yuv, 2, {k_luma16, k_interleaved420_16, {}}, 16, 0},
+    {AV_PIX_FMT_RGBA, render_shader::packed_rgb, 1, {k_packed_rgba, {}, {}}},
+    {AV_PIX_FMT_RGB0, render_shader::packed_rgb, 1, {k_packed_rgba, {}, {}}},
+    {AV_PIX_FMT_BGRA, render_shader::packed_bgr, 1, {k_packed_rgba, {}, {}}},
+    {AV_PIX_FMT_BGR0, render_shader::packed_bgr, 1, {k_packed_rgba, {}, {}}},
+};
+}  // namespace
+
+const render_format *find_render_format(int format)
+{
+    for (const render_format &candidate : k_render_formats)
+    {
+        if (candidate.format == format)
+        {
+            return &candidate;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,49 @@
+#ifndef RENDER_FORMAT_H
+#define RENDER_FORMAT_H
+
+extern "C"
+{
+#include <libavutil/pixfmt.h>
+}
+
+enum class render_shader
+{
+    planar_yuv,
+    semi_planar_yuv,
+    semi_planar_yvu,
+    packed_rgb,
+    packed_bgr
+};
+
+constexpr int k_render_shader_count = 5;
+
+enum class render_transfer
+{
+    sdr,
+    pq,
+    hlg
+};
+
+constexpr int k_render_transfer_count = 3;
+
+struct render_plane
+{
+    int channels = 1;
+    int bytes_per_channel = 1;
+    int width_shift = 0;
+    int height_shift = 0;
+};
+
+struct render_format
+{
+    AVPixelFormat format = AV_PIX_FMT_NONE;
+    render_shader shader = render_shader::planar_yuv;
+    int plane_count = 0;
+    render_plane planes[3];
+    int depth = 8;
+    int shift = 0;
+};
+
+[[nodiscard]] const render_format *find_render_format(int format);
+
+#endif
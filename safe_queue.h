@@ -4,6 +4,7 @@
 #include <queue>
 #include <mutex>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 
 template <typename T>
@@ -33,6 +34,26 @@ class safe_queue
         return true;
     }
 
+    template <typename Rep, typename Period>
+    [[nodiscard]] bool try_push_for(T &value, const std::chrono::duration<Rep, Period> &timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (!cond_not_full_.wait_for(lock, timeout, [this] { return queue_.size() < max_size_ || abort_flag_.load(); }))
+        {
+            return false;
+        }
+
+        if (abort_flag_.load())
+        {
+            return false;
+        }
+
+        queue_.push(std::move(value));
+        cond_not_empty_.notify_one();
+        return true;
+    }
+
     [[nodiscard]] bool pop(T &out_value)
     {
         std::unique_lock<std::mutex> lock(mutex_);
@@ -51,6 +72,23 @@ class safe_queue
         return true;
     }
 
+    template <typename Rep, typename Period>
+    [[nodiscard]] bool try_pop_for(T &out_value, const std::chrono::duration<Rep, Period> &timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (!cond_not_empty_.wait_for(lock, timeout, [this] { return !queue_.empty() || abort_flag_.load(); }) || abort_flag_.load())
+        {
+            return false;
+        }
+
+        out_value = std::move(queue_.front());
+        queue_.pop();
+        cond_not_full_.notify_one();
+
+        return true;
+    }
+
     void clear()
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -68,6 +106,21 @@ class safe_queue
 
     void reset() { abort_flag_.store(false); }
 
+    [[nodiscard]] bool aborted() const { return abort_flag_.load(); }
+
+    void set_max_size(size_t max_size)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_size_ = max_size;
+        cond_not_full_.notify_all();
+    }
+
+    [[nodiscard]] size_t max_size()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return max_size_;
+    }
+
     [[nodiscard]] size_t size()
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
 #include "sdl_audio_backend.h"
 #include "log.h"
@@ -15,6 +16,11 @@ extern "C"
 
 namespace
 {
+constexpr int k_audio_diff_avg_nb = 20;
+constexpr int k_sample_correction_percent_max = 10;
+constexpr double k_audio_nosync_threshold = 10.0;
+constexpr double k_release_threshold_ratio = 0.5;
+
 double frame_pts_seconds(const AVFrame *frame, AVRational time_base)
 {
     if (frame == nullptr || frame->pts == AV_NOPTS_VALUE)
@@ -86,6 +92,7 @@ bool sdl_audio_backend::init(safe_queue<std::shared_ptr<media_frame>> *frame_que
 
     clear_pcm_queue();
     destroy_filter_graph();
+    reset_drift_compensation();
 
     if (SDL_Init(SDL_INIT_AUDIO) != 0)
     {
@@ -98,17 +105,26 @@ bool sdl_audio_backend::init(safe_queue<std::shared_ptr<media_frame>> *frame_que
     wanted_spec.format = AUDIO_S16SYS;
     wanted_spec.channels = static_cast<Uint8>(k_output_channels);
     wanted_spec.silence = 0;
-    wanted_spec.samples = 1024;
+    wanted_spec.samples = k_device_buffer_frames;
     wanted_spec.callback = audio_callback_static;
     wanted_spec.userdata = this;
 
-    audio_dev_ = SDL_OpenAudioDevice(nullptr, 0, &wanted_spec, nullptr, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+    device_spec_ = SDL_AudioSpec{};
+    audio_dev_ = SDL_OpenAudioDevice(nullptr, 0, &wanted_spec, &device_spec_, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
     if (audio_dev_ == 0)
     {
         LOG_ERROR("sdl open audio device failed");
         return false;
     }
 
+    output_sample_rate_ = device_spec_.freq > 0 ? device_spec_.freq : k_output_sample_rate;
+    const int device_frames = device_spec_.samples > 0 ? device_spec_.samples : k_device_buffer_frames;
+    device_buffer_seconds_ = static_cast<double>(device_frames) / static_cast<double>(output_sample_rate_);
+    output_latency_.store(device_buffer_seconds_);
+    calibration_times_.reserve(k_calibration_callbacks);
+    start_latency_calibration();
+    LOG_INFO("sdl audio device obtained rate {} frames {} buffer {:.1f} ms", output_sample_rate_, device_frames, device_buffer_seconds_ * 1000.0);
+
     process_thread_ = std::thread([this]() { process_audio(); });
 
     SDL_PauseAudioDevice(audio_dev_, 0);
@@ -116,12 +132,13 @@ bool sdl_audio_backend::init(safe_queue<std::shared_ptr<media_frame>> *frame_que
     return true;
 }
 
-void sdl_audio_backend::pause(bool p) const
+void sdl_audio_backend::pause(bool p)
 {
     if (audio_dev_ != 0)
     {
         SDL_PauseAudioDevice(audio_dev_, p ? 1 : 0);
     }
+    p ? audio_clock_.pause() : audio_clock_.resume();
 }
 
 void sdl_audio_backend::set_playback_rate(double rate)
@@ -196,6 +213,23 @@ void sdl_audio_backend::close()
     destroy_filter_graph();
 }
 
+double sdl_audio_backend::audio_drift() const { return audio_drift_.load(); }
+
+void sdl_audio_backend::start_latency_calibration()
+{
+    {
+        std::lock_guard<std::mutex> lock(calibration_mutex_);
+        calibration_ = latency_calibration{};
+    }
+    calibration_requested_.store(true);
+}
+
+sdl_audio_backend::latency_calibration sdl_audio_backend::calibration() const
+{
+    std::lock_guard<std::mutex> lock(calibration_mutex_);
+    return calibration_;
+}
+
 void sdl_audio_backend::audio_callback_static(void *userdata, Uint8 *stream, int len)
 {
     auto *backend = static_cast<sdl_audio_backend *>(userdata);
@@ -204,10 +238,10 @@ void sdl_audio_backend::audio_callback_static(void *userdata, Uint8 *stream, int
 
 void sdl_audio_backend::audio_callback(Uint8 *stream, int len)
 {
+    const double callback_time = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
     SDL_memset(stream, 0, static_cast<size_t>(len));
-    const int callback_len = len;
-    const double output_latency_seconds =
-        static_cast<double>(2 * callback_len) / static_cast<double>(k_output_sample_rate * k_output_bytes_per_frame);
+    const double output_latency_seconds = record_callback_timing(callback_time);
+    bool clock_updated = false;
 
     std::lock_guard<std::mutex> lock(pcm_mutex_);
 
@@ -228,18 +262,14 @@ void sdl_audio_backend::audio_callback(Uint8 *stream, int len)
         const int bytes_left = static_cast<int>(chunk.data.size() - chunk.offset);
         const int bytes_to_write = std::min(bytes_left, len);
 
-        if (clock_ != nullptr)
+        if (!clock_updated)
         {
-            if (std::abs(clock_->rate() - chunk.playback_rate) >= 0.0001)
-            {
-                clock_->set_rate(chunk.playback_rate);
-            }
-            const double submitted_frames =
-                static_cast<double>((chunk.offset + static_cast<size_t>(bytes_to_write)) / static_cast<size_t>(k_output_bytes_per_frame));
-            const double submitted_media_seconds = (submitted_frames / static_cast<double>(k_output_sample_rate)) * chunk.playback_rate;
+            const double written_frames = static_cast<double>(chunk.offset / static_cast<size_t>(k_output_bytes_per_frame));
+            const double written_media_seconds =
+                (written_frames / static_cast<double>(output_sample_rate_)) * chunk.playback_rate * chunk.media_scale;
             const double latency_media_seconds = output_latency_seconds * chunk.playback_rate;
-            const double pts = chunk.pts + submitted_media_seconds - latency_media_seconds;
-            clock_->set(pts, chunk.serial);
+            update_clocks(chunk.pts + written_media_seconds - latency_media_seconds, chunk);
+            clock_updated = true;
         }
 
         SDL_MixAudioFormat(stream,
@@ -261,6 +291,127 @@ void sdl_audio_backend::audio_callback(Uint8 *stream, int len)
     }
 }
 
+double sdl_audio_backend::record_callback_timing(double callback_time)
+{
+    if (calibration_requested_.exchange(false))
+    {
+        calibration_times_.clear();
+        calibration_clock_error_sum_ = 0.0;
+        calibration_clock_error_count_ = 0;
+    }
+
+    if (calibration_times_.size() < k_calibration_callbacks)
+    {
+        if (!calibration_times_.empty() && callback_time - calibration_times_.back() > 4.0 * device_buffer_seconds_)
+        {
+            calibration_times_.clear();
+        }
+        calibration_times_.push_back(callback_time);
+        if (calibration_times_.size() == k_calibration_callbacks)
+        {
+            finish_latency_calibration();
+        }
+    }
+
+    return output_latency_.load();
+}
+
+void sdl_audio_backend::finish_latency_calibration()
+{
+    const size_t count = calibration_times_.size();
+    const double period = (calibration_times_.back() - calibration_times_.front()) / static_cast<double>(count - 1);
+
+    double interval_variance = 0.0;
+    double max_offset = 0.0;
+    for (size_t i = 1; i < count; i++)
+    {
+        const double interval = calibration_times_[i] - calibration_times_[i - 1];
+        interval_variance += (interval - period) * (interval - period);
+        max_offset = std::max(max_offset, calibration_times_[i] - (calibration_times_.front() + (static_cast<double>(i) * period)));
+    }
+    interval_variance /= static_cast<double>(count - 1);
+
+    double lead_sum = 0.0;
+    for (size_t i = 0; i < count; i++)
+    {
+        lead_sum += max_offset - (calibration_times_[i] - (calibration_times_.front() + (static_cast<double>(i) * period)));
+    }
+    const double scheduling_lead = lead_sum / static_cast<double>(count);
+    const double output_latency = device_buffer_seconds_ + scheduling_lead;
+    output_latency_.store(output_latency);
+
+    latency_calibration result;
+    result.complete = true;
+    result.callbacks = static_cast<int>(count);
+    result.nominal_period_ms = device_buffer_seconds_ * 1000.0;
+    result.measured_period_ms = period * 1000.0;
+    result.jitter_ms = std::sqrt(interval_variance) * 1000.0;
+    result.scheduling_lead_ms = scheduling_lead * 1000.0;
+    result.output_latency_ms = output_latency * 1000.0;
+    result.clock_step_ms =
+        calibration_clock_error_count_ > 0 ? (calibration_clock_error_sum_ / static_cast<double>(calibration_clock_error_count_)) * 1000.0 : 0.0;
+    if (!calibration_ready_.load(std::memory_order_acquire))
+    {
+        pending_calibration_ = result;
+        calibration_ready_.store(true, std::memory_order_release);
+    }
+}
+
+void sdl_audio_backend::publish_latency_calibration()
+{
+    if (!calibration_ready_.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    const latency_calibration result = pending_calibration_;
+    calibration_ready_.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(calibration_mutex_);
+        calibration_ = result;
+    }
+
+    LOG_INFO("audio latency calibration period {:.2f} ms (nominal {:.2f}) jitter {:.2f} ms lead {:.2f} ms latency {:.2f} ms clock step {:.2f} ms",
+             result.measured_period_ms,
+             result.nominal_period_ms,
+             result.jitter_ms,
+             result.scheduling_lead_ms,
+             result.output_latency_ms,
+             result.clock_step_ms);
+}
+
+void sdl_audio_backend::update_clocks(double pts, const pcm_chunk &chunk)
+{
+    if (calibration_times_.size() < k_calibration_callbacks && audio_clock_.serial() == chunk.serial &&
+        std::abs(audio_clock_.rate() - chunk.playback_rate) < 0.0001)
+    {
+        calibration_clock_error_sum_ += std::abs(audio_clock_.get() - pts);
+        calibration_clock_error_count_++;
+    }
+
+    if (std::abs(audio_clock_.rate() - chunk.playback_rate) >= 0.0001)
+    {
+        audio_clock_.set_rate(chunk.playback_rate);
+    }
+    audio_clock_.set(pts, chunk.serial);
+
+    if (clock_ != nullptr && clock_->master() != clock_master::audio && clock_->serial() == chunk.serial)
+    {
+        output_drift_.store(pts - clock_->get());
+        output_drift_serial_.store(chunk.serial);
+    }
+
+    if (clock_ != nullptr && (clock_->master() == clock_master::audio ||
+                              (clock_->master() == clock_master::external && clock_->serial() != chunk.serial)))
+    {
+        if (std::abs(clock_->rate() - chunk.playback_rate) >= 0.0001)
+        {
+            clock_->set_rate(chunk.playback_rate);
+        }
+        clock_->set(pts, chunk.serial);
+    }
+}
+
 void sdl_audio_backend::process_audio()
 {
     LOG_INFO("sdl audio backend process loop started");
@@ -281,6 +432,7 @@ void sdl_audio_backend::process_audio()
         active_generation = config_generation_.load();
         media_cursor = 0.0;
         media_cursor_valid = false;
+        reset_drift_compensation();
         return true;
     };
 
@@ -298,6 +450,7 @@ void sdl_audio_backend::process_audio()
         {
             break;
         }
+        publish_latency_calibration();
 
         std::shared_ptr<media_frame> frame;
         if (!frame_queue_->pop(frame))
@@ -329,6 +482,7 @@ void sdl_audio_backend::process_audio()
             LOG_INFO("audio process thread received flush");
             clear_pcm_queue();
             destroy_filter_graph();
+            reset_drift_compensation();
             active_generation = config_generation_.load();
             active_flush_generation = flush_generation_.load();
             media_cursor = 0.0;
@@ -430,7 +584,7 @@ void sdl_audio_backend::process_audio()
                 continue;
             }
 
-            const int total_frames = buffer_size / k_output_bytes_per_frame;
+            int total_frames = buffer_size / k_output_bytes_per_frame;
             double chunk_base_pts = media_cursor;
             if (!media_cursor_valid)
             {
@@ -441,6 +595,21 @@ void sdl_audio_backend::process_audio()
                 media_cursor_valid = true;
             }
             const uint8_t *chunk_src = filtered_frame->data[0];
+            double media_scale = 1.0;
+
+            const int wanted_frames = synchronize_audio(total_frames, frame->serial(), playback_rate);
+            if (wanted_frames != total_frames || compensator_active_)
+            {
+                const int compensated_frames = compensate_frame(filtered_frame, total_frames, wanted_frames);
+                if (compensated_frames <= 0)
+                {
+                    av_frame_free(&filtered_frame);
+                    continue;
+                }
+                media_scale = static_cast<double>(total_frames) / static_cast<double>(compensated_frames);
+                chunk_src = compensation_buffer_.data();
+                total_frames = compensated_frames;
+            }
 
             const uint64_t pending_generation = config_generation_.load();
             if (pending_generation != active_generation)
@@ -470,6 +639,7 @@ void sdl_audio_backend::process_audio()
                 chunk.pts = chunk_base_pts;
                 chunk.serial = frame->serial();
                 chunk.playback_rate = playback_rate;
+                chunk.media_scale = media_scale;
 
                 const uint64_t inner_pending_generation = config_generation_.load();
                 if (inner_pending_generation != active_generation)
@@ -499,7 +669,8 @@ void sdl_audio_backend::process_audio()
                 pcm_queue_.push_back(std::move(chunk));
                 pcm_cond_.notify_all();
 
-                chunk_base_pts += (static_cast<double>(frames_this_chunk) / static_cast<double>(k_output_sample_rate)) * playback_rate;
+                chunk_base_pts +=
+                    (static_cast<double>(frames_this_chunk) / static_cast<double>(output_sample_rate_)) * playback_rate * media_scale;
                 media_cursor = chunk_base_pts;
                 frames_offset += frames_this_chunk;
             }
@@ -511,6 +682,119 @@ void sdl_audio_backend::process_audio()
     LOG_INFO("sdl audio backend process loop finished");
 }
 
+int sdl_audio_backend::synchronize_audio(int nb_samples, int serial, double playback_rate)
+{
+    if (clock_ == nullptr || clock_->master() == clock_master::audio)
+    {
+        audio_diff_cum_ = 0.0;
+        audio_diff_avg_count_ = 0;
+        return nb_samples;
+    }
+    if (output_drift_serial_.load() != serial || clock_->serial() != serial)
+    {
+        return nb_samples;
+    }
+
+    const double diff = output_drift_.load() + queued_correction();
+    if (!std::isfinite(diff) || std::abs(diff) >= k_audio_nosync_threshold)
+    {
+        audio_diff_cum_ = 0.0;
+        audio_diff_avg_count_ = 0;
+        return nb_samples;
+    }
+
+    static const double diff_avg_coef = std::exp(std::log(0.01) / k_audio_diff_avg_nb);
+    audio_diff_cum_ = diff + (diff_avg_coef * audio_diff_cum_);
+    if (audio_diff_avg_count_ < k_audio_diff_avg_nb)
+    {
+        audio_diff_avg_count_++;
+        return nb_samples;
+    }
+
+    const double avg_diff = audio_diff_cum_ * (1.0 - diff_avg_coef);
+    audio_drift_.store(avg_diff);
+    const double diff_threshold = compensator_active_ ? device_buffer_seconds_ * k_release_threshold_ratio : device_buffer_seconds_;
+    if (std::abs(avg_diff) < diff_threshold)
+    {
+        return nb_samples;
+    }
+
+    const int wanted = nb_samples + static_cast<int>((diff / playback_rate) * static_cast<double>(output_sample_rate_));
+    const int min_samples = nb_samples * (100 - k_sample_correction_percent_max) / 100;
+    const int max_samples = nb_samples * (100 + k_sample_correction_percent_max) / 100;
+    const int clamped = std::clamp(wanted, min_samples, max_samples);
+    LOG_TRACE("audio drift diff {:.3f} avg {:.3f} samples {} -> {}", diff, avg_diff, nb_samples, clamped);
+    return clamped;
+}
+
+double sdl_audio_backend::queued_correction()
+{
+    std::lock_guard<std::mutex> lock(pcm_mutex_);
+    double correction = 0.0;
+    for (const pcm_chunk &chunk : pcm_queue_)
+    {
+        const double frames = static_cast<double>((chunk.data.size() - chunk.offset) / static_cast<size_t>(k_output_bytes_per_frame));
+        correction += (frames / static_cast<double>(output_sample_rate_)) * chunk.playback_rate * (chunk.media_scale - 1.0);
+    }
+    return correction;
+}
+
+int sdl_audio_backend::compensate_frame(const AVFrame *frame, int nb_samples, int wanted_samples)
+{
+#if LIBAVUTIL_VERSION_MAJOR >= 57
+    audio_channel_layout stereo_layout{};
+    av_channel_layout_default(&stereo_layout, k_output_channels);
+#else
+    const audio_channel_layout stereo_layout = AV_CH_LAYOUT_STEREO;
+#endif
+    const bool ready = compensator_.init(
+        &stereo_layout, output_sample_rate_, AV_SAMPLE_FMT_S16, &stereo_layout, output_sample_rate_, AV_SAMPLE_FMT_S16);
+#if LIBAVUTIL_VERSION_MAJOR >= 57
+    av_channel_layout_uninit(&stereo_layout);
+#endif
+    if (!ready)
+    {
+        LOG_ERROR("audio drift compensator init failed");
+        return -1;
+    }
+    if (!compensator_active_)
+    {
+        LOG_INFO("audio drift compensation engaged");
+        compensator_active_ = true;
+    }
+
+    if (wanted_samples != nb_samples && !compensator_.set_compensation(wanted_samples - nb_samples, wanted_samples))
+    {
+        return -1;
+    }
+
+    const int out_capacity = wanted_samples + 256;
+    compensation_buffer_.resize(static_cast<size_t>(out_capacity * k_output_bytes_per_frame));
+    uint8_t *out = compensation_buffer_.data();
+    const int converted = compensator_.convert(&out, out_capacity, frame);
+    if (converted < 0 || wanted_samples != nb_samples)
+    {
+        return converted;
+    }
+
+    uint8_t *tail = out + static_cast<ptrdiff_t>(converted * k_output_bytes_per_frame);
+    const int drained = compensator_.drain(&tail, out_capacity - converted);
+    compensator_.reset();
+    compensator_active_ = false;
+    LOG_INFO("audio drift compensation released drift {:.3f}", audio_drift_.load());
+    return converted + std::max(drained, 0);
+}
+
+void sdl_audio_backend::reset_drift_compensation()
+{
+    compensator_.reset();
+    compensator_active_ = false;
+    audio_diff_cum_ = 0.0;
+    audio_diff_avg_count_ = 0;
+    audio_drift_.store(0.0);
+    output_drift_serial_.store(-1);
+}
+
 void sdl_audio_backend::clear_pcm_queue()
 {
     std::lock_guard<std::mutex> lock(pcm_mutex_);
@@ -649,12 +933,9 @@ bool sdl_audio_backend::configure_filter_graph(const AVFrame *frame, double play
     }
 
     AVFilterContext *format_ctx = nullptr;
-    ret = avfilter_graph_create_filter(&format_ctx,
-                                       aformat,
-                                       "format",
-                                       "sample_fmts=s16:sample_rates=44100:channel_layouts=stereo",
-                                       nullptr,
-                                       filter_graph_);
+    char format_args[128] = {0};
+    std::snprintf(format_args, sizeof(format_args), "sample_fmts=s16:sample_rates=%d:channel_layouts=stereo", output_sample_rate_);
+    ret = avfilter_graph_create_filter(&format_ctx, aformat, "format", format_args, nullptr, filter_graph_);
     if (ret < 0)
     {
         LOG_ERROR("audio filter graph failed to create aformat code {}", ret);
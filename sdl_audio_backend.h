@@ -24,6 +24,19 @@ extern "C"
 
 class sdl_audio_backend
 {
+   public:
+    struct latency_calibration
+    {
+        bool complete = false;
+        int callbacks = 0;
+        double nominal_period_ms = 0.0;
+        double measured_period_ms = 0.0;
+        double jitter_ms = 0.0;
+        double scheduling_lead_ms = 0.0;
+        double output_latency_ms = 0.0;
+        double clock_step_ms = 0.0;
+    };
+
    public:
     sdl_audio_backend() = default;
 
@@ -34,11 +47,14 @@ class sdl_audio_backend
               safe_queue<std::shared_ptr<media_packet>> *packet_queue,
               AVRational tb,
               av_clock *clk);
-    void pause(bool p) const;
+    void pause(bool p);
     void set_playback_rate(double rate);
     void set_volume(int percent);
     void flush();
     void close();
+    [[nodiscard]] double audio_drift() const;
+    void start_latency_calibration();
+    [[nodiscard]] latency_calibration calibration() const;
 
    private:
     struct pcm_chunk
@@ -48,10 +64,15 @@ class sdl_audio_backend
         double pts = 0.0;
         int serial = -1;
         double playback_rate = 1.0;
+        double media_scale = 1.0;
     };
 
     static void audio_callback_static(void *userdata, Uint8 *stream, int len);
     void audio_callback(Uint8 *stream, int len);
+    double record_callback_timing(double callback_time);
+    void finish_latency_calibration();
+    void publish_latency_calibration();
+    void update_clocks(double pts, const pcm_chunk &chunk);
     void process_audio();
     void clear_pcm_queue();
     void trim_pcm_queue_for_rate_change();
@@ -59,18 +80,37 @@ class sdl_audio_backend
     bool configure_filter_graph(const AVFrame *frame, double playback_rate);
     bool filter_matches_frame(const AVFrame *frame) const;
     bool update_filter_playback_rate(double playback_rate);
+    int synchronize_audio(int nb_samples, int serial, double playback_rate);
+    [[nodiscard]] double queued_correction();
+    int compensate_frame(const AVFrame *frame, int nb_samples, int wanted_samples);
+    void reset_drift_compensation();
 
    private:
     static constexpr int k_output_sample_rate = 44100;
     static constexpr int k_output_channels = 2;
     static constexpr int k_output_bytes_per_frame = 4;
     static constexpr int k_output_chunk_frames = 512;
+    static constexpr int k_device_buffer_frames = 1024;
+    static constexpr size_t k_calibration_callbacks = 256;
     static constexpr size_t k_max_pcm_queue_bytes = static_cast<size_t>(k_output_sample_rate * k_output_bytes_per_frame * 2);
     static constexpr AVRational k_filter_time_base = {1, AV_TIME_BASE};
 
     AVRational time_base_{0, 1};
     av_clock *clock_ = nullptr;
+    av_clock audio_clock_;
     SDL_AudioDeviceID audio_dev_ = 0;
+    SDL_AudioSpec device_spec_{};
+    int output_sample_rate_ = k_output_sample_rate;
+    double device_buffer_seconds_ = 0.0;
+    std::atomic<double> output_latency_{0.0};
+    std::atomic<bool> calibration_requested_{false};
+    std::vector<double> calibration_times_;
+    double calibration_clock_error_sum_ = 0.0;
+    int calibration_clock_error_count_ = 0;
+    latency_calibration pending_calibration_;
+    std::atomic<bool> calibration_ready_{false};
+    latency_calibration calibration_;
+    mutable std::mutex calibration_mutex_;
     std::thread process_thread_;
     std::atomic<bool> stop_{false};
     std::atomic<double> playback_rate_{1.0};
@@ -90,6 +130,14 @@ class sdl_audio_backend
     int filter_src_rate_ = 0;
     AVSampleFormat filter_src_fmt_ = AV_SAMPLE_FMT_NONE;
     double filter_playback_rate_ = 1.0;
+    audio_resampler compensator_;
+    bool compensator_active_ = false;
+    std::vector<uint8_t> compensation_buffer_;
+    double audio_diff_cum_ = 0.0;
+    int audio_diff_avg_count_ = 0;
+    std::atomic<double> audio_drift_{0.0};
+    std::atomic<double> output_drift_{0.0};
+    std::atomic<int> output_drift_serial_{-1};
     safe_queue<std::shared_ptr<media_frame>> *frame_queue_ = nullptr;
     safe_queue<std::shared_ptr<media_packet>> *packet_queue_ = nullptr;
 };
@@ -0,0 +1,126 @@
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <thread>
+#include <vector>
+#include "av_clock.h"
+
+namespace
+{
+constexpr double k_serial_span = 1000.0;
+constexpr double k_max_rate = 4.0;
+constexpr double k_tolerance = 1e-6;
+constexpr int k_reader_count = 4;
+constexpr auto k_run_time = std::chrono::seconds(2);
+constexpr auto k_seek_interval = std::chrono::milliseconds(2);
+
+struct reader_result
+{
+    uint64_t reads = 0;
+    uint64_t backwards = 0;
+    uint64_t torn = 0;
+    double worst_step = 0.0;
+};
+
+void seek_writer(av_clock &clock, const std::atomic<bool> &running)
+{
+    int serial = 0;
+    while (running.load())
+    {
+        serial++;
+        clock.set(serial * k_serial_span, serial);
+        std::this_thread::sleep_for(k_seek_interval);
+    }
+}
+
+void rate_writer(av_clock &clock, const std::atomic<bool> &running)
+{
+    const double rates[] = {0.5, 1.0, 2.0, k_max_rate, 1.5};
+    size_t index = 0;
+    while (running.load())
+    {
+        clock.set_rate(rates[index % std::size(rates)]);
+        if (index % 7 == 0)
+        {
+            clock.pause();
+            std::this_thread::yield();
+            clock.resume();
+        }
+        index++;
+        std::this_thread::yield();
+    }
+}
+
+void reader(const av_clock &clock, const std::atomic<bool> &running, reader_result &result)
+{
+    int last_serial = -1;
+    double last_value = 0.0;
+    while (running.load())
+    {
+        const int before = clock.serial();
+        const double value = clock.get();
+        const int after = clock.serial();
+        result.reads++;
+        if (before != after || before <= 0)
+        {
+            last_serial = -1;
+            continue;
+        }
+
+        const double origin = before * k_serial_span;
+        if (value < origin - k_tolerance || value >= origin + k_serial_span)
+        {
+            result.torn++;
+        }
+        if (before == last_serial && value < last_value - k_tolerance)
+        {
+            result.backwards++;
+            result.worst_step = std::max(result.worst_step, last_value - value);
+        }
+        last_serial = before;
+        last_value = value;
+    }
+}
+}  // namespace
+
+int main()
+{
+    av_clock clock;
+    clock.set(0.0, 0);
+    std::atomic<bool> running{true};
+    std::vector<reader_result> results(k_reader_count);
+
+    std::vector<std::thread> threads;
+    threads.emplace_back(seek_writer, std::ref(clock), std::cref(running));
+    threads.emplace_back(rate_writer, std::ref(clock), std::cref(running));
+    threads.emplace_back(rate_writer, std::ref(clock), std::cref(running));
+    for (reader_result &result : results)
+    {
+        threads.emplace_back(reader, std::cref(clock), std::cref(running), std::ref(result));
+    }
+
+    std::this_thread::sleep_for(k_run_time);
+    running.store(false);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    reader_result total;
+    for (const reader_result &result : results)
+    {
+        total.reads += result.reads;
+        total.backwards += result.backwards;
+        total.torn += result.torn;
+        total.worst_step = std::max(total.worst_step, result.worst_step);
+    }
+
+    std::printf("av_clock stress reads %llu backwards %llu torn %llu worst backward step %.9f\n",
+                static_cast<unsigned long long>(total.reads),
+                static_cast<unsigned long long>(total.backwards),
+                static_cast<unsigned long long>(total.torn),
+                total.worst_step);
+    return total.reads > 0 && total.backwards == 0 && total.torn == 0 ? 0 : 1;
+}
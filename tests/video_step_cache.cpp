@@ -0,0 +1,242 @@
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <QCoreApplication>
+#include "av_clock.h"
+#include "media_objects.h"
+#include "safe_queue.h"
+#include "video_sync_thread.h"
+
+namespace
+{
+constexpr AVRational k_time_base{1, 25};
+constexpr int k_played_frames = 10;
+constexpr size_t k_playback_window = 4;
+constexpr double k_tolerance = 1e-6;
+constexpr auto k_wait_timeout = std::chrono::seconds(5);
+
+struct observer
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<double> presented;
+    std::vector<double> stepped;
+    std::vector<double> misses;
+};
+
+double to_seconds(int index) { return index * av_q2d(k_time_base); }
+
+std::shared_ptr<media_frame> make_frame(int index, int serial)
+{
+    auto frame = std::make_shared<media_frame>();
+    AVFrame *raw = frame->raw();
+    raw->format = AV_PIX_FMT_YUV420P;
+    raw->width = 16;
+    raw->height = 16;
+    raw->pts = index;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 30, 100)
+    raw->duration = 1;
+#else
+    raw->pkt_duration = 1;
+#endif
+    if (av_frame_get_buffer(raw, 32) < 0)
+    {
+        return nullptr;
+    }
+    frame->set_serial(serial);
+    return frame;
+}
+
+bool wait_until(observer &events, const std::function<bool()> &ready)
+{
+    std::unique_lock<std::mutex> lock(events.mutex);
+    return events.cv.wait_for(lock, k_wait_timeout, ready);
+}
+
+bool same_pts(double a, double b) { return std::abs(a - b) < k_tolerance; }
+
+bool step_backward(video_sync_thread &sync, observer &events, bool &hit, double &pts)
+{
+    size_t stepped = 0;
+    size_t misses = 0;
+    {
+        std::lock_guard<std::mutex> lock(events.mutex);
+        stepped = events.stepped.size();
+        misses = events.misses.size();
+    }
+
+    sync.request_step(-1);
+    if (!wait_until(events, [&]() { return events.stepped.size() > stepped || events.misses.size() > misses; }))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(events.mutex);
+    hit = events.stepped.size() > stepped;
+    pts = hit ? events.stepped.back() : events.misses.back();
+    return true;
+}
+
+int fail(const char *what)
+{
+    std::printf("video step cache failed: %s\n", what);
+    return 1;
+}
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    safe_queue<std::shared_ptr<media_frame>> frames(16);
+    safe_queue<std::shared_ptr<media_packet>> packets(16);
+    av_clock clock;
+    clock.set(0.0, packets.serial());
+
+    observer events;
+    video_sync_thread sync(&frames, &packets, k_time_base, &clock);
+    QObject::connect(
+        &sync,
+        &video_sync_thread::frame_ready,
+        &sync,
+        [&events](const std::shared_ptr<media_frame> &frame)
+        {
+            std::lock_guard<std::mutex> lock(events.mutex);
+            events.presented.push_back(static_cast<double>(frame->raw()->pts) * av_q2d(k_time_base));
+            events.cv.notify_all();
+        },
+        Qt::DirectConnection);
+    QObject::connect(
+        &sync,
+        &video_sync_thread::stepped,
+        &sync,
+        [&events](double pts)
+        {
+            std::lock_guard<std::mutex> lock(events.mutex);
+            events.stepped.push_back(pts);
+            events.cv.notify_all();
+        },
+        Qt::DirectConnection);
+    QObject::connect(
+        &sync,
+        &video_sync_thread::step_cache_miss,
+        &sync,
+        [&events](double pts)
+        {
+            std::lock_guard<std::mutex> lock(events.mutex);
+            events.misses.push_back(pts);
+            events.cv.notify_all();
+        },
+        Qt::DirectConnection);
+    sync.start();
+
+    int result = 0;
+    for (int index = 0; index < k_played_frames && result == 0; index++)
+    {
+        if (!frames.push(make_frame(index, packets.serial())) ||
+            !wait_until(events, [&]() { return events.presented.size() > static_cast<size_t>(index); }))
+        {
+            result = fail("playback did not present every frame");
+        }
+    }
+
+    if (result == 0)
+    {
+        clock.pause();
+        sync.paused(true);
+        const frame_cache::stats cache = sync.cache_stats();
+        std::printf("video step cache after playback frames %zu bytes %zu\n", cache.frames, cache.bytes);
+        if (cache.frames > k_playback_window)
+        {
+            result = fail("playback kept more than the playback window in the step cache");
+        }
+        if (!frames.push(make_frame(k_played_frames, packets.serial())))
+        {
+            result = fail("could not queue the pending frame");
+        }
+    }
+
+    double miss_pts = -1.0;
+    size_t hits = 0;
+    double expected = to_seconds(k_played_frames - 2);
+    while (result == 0 && miss_pts < 0.0)
+    {
+        bool hit = false;
+        double pts = 0.0;
+        if (!step_backward(sync, events, hit, pts))
+        {
+            result = fail("backward step produced neither a cached frame nor a miss");
+            break;
+        }
+        if (!hit)
+        {
+            miss_pts = pts;
+            break;
+        }
+        if (!same_pts(pts, expected))
+        {
+            result = fail("backward step hit the cache at the wrong frame");
+            break;
+        }
+        hits++;
+        expected -= to_seconds(1);
+    }
+
+    if (result == 0 && (hits == 0 || miss_pts <= 0.0 || !same_pts(miss_pts, expected + to_seconds(1))))
+    {
+        result = fail("backward steps did not hit the cache and then miss inside the stream");
+    }
+
+    if (result == 0)
+    {
+        const double target = miss_pts - (to_seconds(1) * 0.5);
+        packets.add_serial();
+        const int serial = packets.serial();
+        clock.set(target, serial);
+        bool queued = frames.push(media_frame::create_flush());
+        for (int index = 0; queued && index < k_played_frames; index++)
+        {
+            queued = frames.push(make_frame(index, serial));
+        }
+
+        size_t stepped = 0;
+        {
+            std::lock_guard<std::mutex> lock(events.mutex);
+            stepped = events.stepped.size();
+        }
+        sync.request_step_to(target);
+        if (!queued || !wait_until(events, [&]() { return events.stepped.size() > stepped; }))
+        {
+            result = fail("re-seek after a cache miss did not step");
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(events.mutex);
+            if (!same_pts(events.stepped.back(), miss_pts - to_seconds(1)))
+            {
+                result = fail("re-seek after a cache miss landed on the wrong frame");
+            }
+        }
+    }
+
+    if (result == 0)
+    {
+        bool hit = false;
+        double pts = 0.0;
+        if (!step_backward(sync, events, hit, pts) || !hit || !same_pts(pts, miss_pts - to_seconds(2)))
+        {
+            result = fail("backward step after the re-seek did not hit the refilled cache");
+        }
+    }
+
+    sync.stop();
+    frames.abort();
+    sync.wait();
+
+    std::printf("video step cache hits %zu miss at %.3f result %d\n", hits, miss_pts, result);
+    return result;
+}
@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <chrono>
+#include <QOpenGLContext>
+#include <QWindow>
+#include "log.h"
+#include "video_render_thread.h"
+
+namespace
+{
+constexpr uint64_t k_present_window = 600;
+constexpr double k_present_idle_ms = 250.0;
+}  // namespace
+
+video_render_thread::video_render_thread(QWindow *surface, vsync_pacer *pacer, QObject *parent)
+    : QThread(parent), surface_(surface), pacer_(pacer), threaded_(QOpenGLContext::supportsThreadedOpenGL())
+{
+    LOG_INFO("video render thread constructed threaded gl {}", threaded_);
+}
+
+video_render_thread::~video_render_thread() { stop(); }
+
+void video_render_thread::submit_frame(std::shared_ptr<media_frame> frame)
+{
+    mailbox_.post(std::move(frame));
+    if (!repaint_requested_.exchange(true, std::memory_order_acq_rel))
+    {
+        wake();
+    }
+}
+
+void video_render_thread::clear()
+{
+    mailbox_.clear();
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex_);
+        frame_ = nullptr;
+        generation_++;
+    }
+    request_repaint();
+}
+
+void video_render_thread::request_repaint()
+{
+    repaint_requested_.store(true, std::memory_order_release);
+    wake();
+}
+
+void video_render_thread::set_drawable_size(QSize size)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (size == drawable_size_)
+        {
+            return;
+        }
+        drawable_size_ = size;
+    }
+    request_repaint();
+}
+
+void video_render_thread::set_exposed(bool exposed)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        exposed_ = exposed;
+    }
+    if (exposed)
+    {
+        request_repaint();
+    }
+}
+
+void video_render_thread::suspend()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        suspended_ = true;
+    }
+    std::lock_guard<std::mutex> render_lock(render_mutex_);
+}
+
+void video_render_thread::resume()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        suspended_ = false;
+    }
+    request_repaint();
+}
+
+void video_render_thread::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+
+    if (threaded_)
+    {
+        wait();
+        return;
+    }
+
+    if (gui_context_ != nullptr && renderer_initialized_ && gui_context_->makeCurrent(surface_))
+    {
+        renderer_.cleanup();
+        gui_context_->doneCurrent();
+    }
+    renderer_initialized_ = false;
+    gui_context_.reset();
+}
+
+bool video_render_thread::threaded() const { return threaded_; }
+
+video_renderer::upload_stats video_render_thread::upload_timing() const { return renderer_.upload_timing(); }
+
+video_render_thread::render_stats video_render_thread::render_timing() const
+{
+    render_stats stats;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats = stats_;
+    }
+    stats.received = mailbox_.posted();
+    stats.superseded = mailbox_.replaced();
+    stats.paint = renderer_.paint_timing();
+    return stats;
+}
+
+std::shared_ptr<media_frame> video_render_thread::current_frame() const
+{
+    std::lock_guard<std::mutex> lock(frame_mutex_);
+    return frame_;
+}
+
+void video_render_thread::wake()
+{
+    if (threaded_)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        cv_.notify_one();
+        return;
+    }
+
+    if (!gui_render_queued_.exchange(true, std::memory_order_acq_rel))
+    {
+        QMetaObject::invokeMethod(this, [this]() { render_on_gui_thread(); }, Qt::QueuedConnection);
+    }
+}
+
+void video_render_thread::run()
+{
+    QOpenGLContext context;
+    context.setFormat(surface_->requestedFormat());
+    if (!context.create())
+    {
+        LOG_ERROR("video render thread failed to create gl context");
+        return;
+    }
+    LOG_INFO("video render thread started gl {}.{}", context.format().majorVersion(), context.format().minorVersion());
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stop_ || (repaint_requested_.load(std::memory_order_acquire) && exposed_ && !suspended_); });
+            if (stop_)
+            {
+                break;
+            }
+        }
+        render_next(&context);
+    }
+
+    if (renderer_initialized_ && context.makeCurrent(surface_))
+    {
+        renderer_.cleanup();
+        context.doneCurrent();
+    }
+    renderer_initialized_ = false;
+    LOG_INFO("video render thread stopped");
+}
+
+void video_render_thread::render_on_gui_thread()
+{
+    gui_render_queued_.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_)
+        {
+            return;
+        }
+    }
+
+    if (gui_context_ == nullptr)
+    {
+        gui_context_ = std::make_unique<QOpenGLContext>();
+        gui_context_->setFormat(surface_->requestedFormat());
+        if (!gui_context_->create())
+        {
+            LOG_ERROR("video render thread failed to create gui thread gl context");
+            gui_context_.reset();
+            return;
+        }
+    }
+    render_next(gui_context_.get());
+}
+
+bool video_render_thread::render_next(QOpenGLContext *context)
+{
+    std::lock_guard<std::mutex> render_lock(render_mutex_);
+    QSize drawable;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_ || suspended_ || !exposed_)
+        {
+            return false;
+        }
+        drawable = drawable_size_;
+    }
+
+    if (!repaint_requested_.exchange(false, std::memory_order_acq_rel))
+    {
+        return false;
+    }
+
+    std::shared_ptr<media_frame> frame;
+    uint64_t generation = 0;
+    bool arrived = false;
+    {
+        std::shared_ptr<media_frame> incoming;
+        arrived = mailbox_.take(incoming);
+        std::lock_guard<std::mutex> lock(frame_mutex_);
+        if (arrived)
+        {
+            frame_ = std::move(incoming);
+            generation_++;
+        }
+        frame = frame_;
+        generation = generation_;
+    }
+
+    if (!context->makeCurrent(surface_))
+    {
+        LOG_WARN("video render thread make current failed");
+        return false;
+    }
+
+    if (!renderer_initialized_)
+    {
+        renderer_.initialize(context);
+        renderer_initialized_ = true;
+    }
+
+    renderer_.render(frame, generation, drawable);
+    context->swapBuffers(surface_);
+    const vsync_pacer::clock::time_point swapped = vsync_pacer::clock::now();
+    if (pacer_ != nullptr)
+    {
+        pacer_->on_frame_swapped(swapped);
+    }
+    context->doneCurrent();
+    record_present(swapped, arrived && frame != nullptr);
+    return true;
+}
+
+void video_render_thread::record_present(vsync_pacer::clock::time_point when, bool new_frame)
+{
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if (new_frame)
+    {
+        stats_.painted++;
+    }
+
+    const bool first = last_present_ == vsync_pacer::clock::time_point{};
+    const double interval_ms = std::chrono::duration<double, std::milli>(when - last_present_).count();
+    last_present_ = when;
+    if (first || interval_ms > k_present_idle_ms)
+    {
+        return;
+    }
+
+    presents_++;
+    stats_.present_average_ms = presents_ == 1 ? interval_ms : (stats_.present_average_ms * 0.9) + (interval_ms * 0.1);
+    present_window_peak_ms_ = std::max(present_window_peak_ms_, interval_ms);
+    stats_.present_peak_ms = std::max(stats_.present_peak_ms, interval_ms);
+    if (presents_ % k_present_window == 0)
+    {
+        LOG_DEBUG("video render thread present avg {:.2f} ms peak {:.2f} ms painted {}", stats_.present_average_ms, present_window_peak_ms_, stats_.painted);
+        stats_.present_peak_ms = present_window_peak_ms_;
+        present_window_peak_ms_ = 0.0;
+    }
+}
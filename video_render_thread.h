@@ -0,0 +1,90 @@
+#ifndef VIDEO_RENDER_THREAD_H
+#define VIDEO_RENDER_THREAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <QThread>
+#include <QSize>
+#include "media_objects.h"
+#include "frame_mailbox.h"
+#include "video_renderer.h"
+#include "vsync_pacer.h"
+
+class QOpenGLContext;
+class QWindow;
+
+class video_render_thread : public QThread
+{
+    Q_OBJECT
+
+   public:
+    video_render_thread(QWindow *surface, vsync_pacer *pacer, QObject *parent = nullptr);
+    ~video_render_thread() override;
+
+   public:
+    struct render_stats
+    {
+        uint64_t received = 0;
+        uint64_t superseded = 0;
+        uint64_t painted = 0;
+        double present_average_ms = 0.0;
+        double present_peak_ms = 0.0;
+        video_renderer::paint_stats paint;
+    };
+
+   public:
+    void submit_frame(std::shared_ptr<media_frame> frame);
+    void clear();
+    void request_repaint();
+    void set_drawable_size(QSize size);
+    void set_exposed(bool exposed);
+    void suspend();
+    void resume();
+    void stop();
+    [[nodiscard]] bool threaded() const;
+    [[nodiscard]] std::shared_ptr<media_frame> current_frame() const;
+    [[nodiscard]] video_renderer::upload_stats upload_timing() const;
+    [[nodiscard]] render_stats render_timing() const;
+
+   protected:
+    void run() override;
+
+   private:
+    void wake();
+    bool render_next(QOpenGLContext *context);
+    void render_on_gui_thread();
+    void record_present(vsync_pacer::clock::time_point when, bool new_frame);
+
+   private:
+    QWindow *surface_ = nullptr;
+    vsync_pacer *pacer_ = nullptr;
+    video_renderer renderer_;
+    bool renderer_initialized_ = false;
+    bool threaded_ = false;
+    std::unique_ptr<QOpenGLContext> gui_context_;
+
+    frame_mailbox mailbox_;
+    std::atomic<bool> repaint_requested_{false};
+    std::atomic<bool> gui_render_queued_{false};
+    std::shared_ptr<media_frame> frame_;
+    uint64_t generation_ = 0;
+    mutable std::mutex frame_mutex_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    QSize drawable_size_;
+    bool exposed_ = false;
+    bool suspended_ = false;
+    bool stop_ = false;
+    std::mutex render_mutex_;
+
+    mutable std::mutex stats_mutex_;
+    render_stats stats_;
+    double present_window_peak_ms_ = 0.0;
+    uint64_t presents_ = 0;
+    vsync_pacer::clock::time_point last_present_{};
+};
+
+#endif
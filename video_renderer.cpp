@@ -0,0 +1,750 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <QElapsedTimer>
+#include "log.h"
+#include "video_renderer.h"
+
+extern "C"
+{
+#include <libavutil/mathematics.h>
+#include <libavutil/rational.h>
+#include <libavutil/mastering_display_metadata.h>
+}
+
+namespace
+{
+struct display_rect
+{
+    int width = 1;
+    int height = 1;
+};
+
+display_rect calculate_display_rect(int scr_width, int scr_height, int pic_width, int pic_height, AVRational pic_sar)
+{
+    AVRational aspect_ratio = pic_sar;
+    int64_t width = 0;
+    int64_t height = 0;
+
+    if (scr_width <= 0 || scr_height <= 0 || pic_width <= 0 || pic_height <= 0)
+    {
+        return {};
+    }
+
+    if (av_cmp_q(aspect_ratio, av_make_q(0, 1)) <= 0)
+    {
+        aspect_ratio = av_make_q(1, 1);
+    }
+
+    aspect_ratio = av_mul_q(aspect_ratio, av_make_q(pic_width, pic_height));
+
+    height = scr_height;
+    width = av_rescale(height, aspect_ratio.num, aspect_ratio.den) & ~1LL;
+    if (width > scr_width)
+    {
+        width = scr_width;
+        height = av_rescale(width, aspect_ratio.den, aspect_ratio.num) & ~1LL;
+    }
+
+    return {std::max(1, static_cast<int>(width)), std::max(1, static_cast<int>(height))};
+}
+
+constexpr const char *k_vertex_shader =
+    "#version 120\n"
+    "attribute vec4 position;\n"
+    "attribute vec2 texCoord;\n"
+    "varying vec2 vTexCoord;\n"
+    "void main() {\n"
+    "    gl_Position = position;\n"
+    "    vTexCoord = texCoord;\n"
+    "}\n";
+
+constexpr const char *k_fragment_header =
+    "#version 120\n"
+    "varying vec2 vTexCoord;\n"
+    "uniform sampler2D tex0;\n"
+    "uniform sampler2D tex1;\n"
+    "uniform sampler2D tex2;\n"
+    "uniform mat4 colorMatrix;\n"
+    "uniform float sampleScale;\n"
+    "uniform float peakLuminance;\n"
+    "uniform mat3 gamutMatrix;\n"
+    "const vec3 lumaCoeffs = vec3(0.2627, 0.6780, 0.0593);\n"
+    "vec3 pq_to_linear(vec3 e) {\n"
+    "    vec3 p = pow(max(e, 0.0), vec3(1.0 / 78.84375));\n"
+    "    vec3 l = pow(max(p - 0.8359375, 0.0) / (18.8515625 - 18.6875 * p), vec3(1.0 / 0.1593017578125));\n"
+    "    return l * (10000.0 / 203.0);\n"
+    "}\n"
+    "vec3 hlg_to_linear(vec3 e) {\n"
+    "    e = max(e, 0.0);\n"
+    "    vec3 low = e * e / 3.0;\n"
+    "    vec3 high = (exp((e - 0.55991073) / 0.17883277) + 0.28466892) / 12.0;\n"
+    "    vec3 scene = mix(low, high, step(0.5, e));\n"
+    "    float ys = dot(scene, lumaCoeffs);\n"
+    "    return scene * pow(max(ys, 1e-6), 0.2) * (1000.0 / 203.0);\n"
+    "}\n"
+    "vec3 tone_map(vec3 rgb) {\n"
+    "    float l = dot(rgb, lumaCoeffs);\n"
+    "    float mapped = l * (1.0 + l / (peakLuminance * peakLuminance)) / (1.0 + l);\n"
+    "    rgb *= mapped / max(l, 1e-6);\n"
+    "    rgb = clamp(gamutMatrix * rgb, 0.0, 1.0);\n"
+    "    return pow(rgb, vec3(1.0 / 2.2));\n"
+    "}\n"
+    "void main() {\n";
+
+constexpr uint64_t k_upload_log_interval = 600;
+constexpr uint64_t k_paint_log_interval = 600;
+constexpr GLenum k_gl_time_elapsed = 0x88BF;
+constexpr float k_sdr_white_nits = 203.0F;
+constexpr float k_default_hdr_peak_nits = 1000.0F;
+constexpr float k_bt2020_to_bt709[] = {1.6605F, -0.5876F, -0.0728F, -0.1246F, 1.1329F, -0.0083F, -0.0182F, -0.1006F, 1.1187F};
+
+constexpr const char *k_texture_uniforms[] = {"tex0", "tex1", "tex2"};
+
+const char *fragment_sample(render_shader shader)
+{
+    switch (shader)
+    {
+        case render_shader::semi_planar_yuv:
+            return "    vec3 yuv = vec3(texture2D(tex0, vTexCoord).r, texture2D(tex1, vTexCoord).rg) * sampleScale;\n"
+                   "    vec3 rgb = (colorMatrix * vec4(yuv, 1.0)).rgb;\n";
+        case render_shader::semi_planar_yvu:
+            return "    vec3 yuv = vec3(texture2D(tex0, vTexCoord).r, texture2D(tex1, vTexCoord).gr) * sampleScale;\n"
+                   "    vec3 rgb = (colorMatrix * vec4(yuv, 1.0)).rgb;\n";
+        case render_shader::packed_rgb:
+            return "    vec3 rgb = texture2D(tex0, vTexCoord).rgb;\n";
+        case render_shader::packed_bgr:
+            return "    vec3 rgb = texture2D(tex0, vTexCoord).bgr;\n";
+        case render_shader::planar_yuv:
+        default:
+            return "    vec3 yuv = vec3(texture2D(tex0, vTexCoord).r, texture2D(tex1, vTexCoord).r, texture2D(tex2, vTexCoord).r) * sampleScale;\n"
+                   "    vec3 rgb = (colorMatrix * vec4(yuv, 1.0)).rgb;\n";
+    }
+}
+
+const char *fragment_output(render_transfer transfer)
+{
+    switch (transfer)
+    {
+        case render_transfer::pq:
+            return "    gl_FragColor = vec4(tone_map(pq_to_linear(rgb)), 1.0);\n";
+        case render_transfer::hlg:
+            return "    gl_FragColor = vec4(tone_map(hlg_to_linear(rgb)), 1.0);\n";
+        case render_transfer::sdr:
+        default:
+            return "    gl_FragColor = vec4(rgb, 1.0);\n";
+    }
+}
+
+render_transfer transfer_for(AVColorTransferCharacteristic trc)
+{
+    if (trc == AVCOL_TRC_SMPTE2084)
+    {
+        return render_transfer::pq;
+    }
+    if (trc == AVCOL_TRC_ARIB_STD_B67)
+    {
+        return render_transfer::hlg;
+    }
+    return render_transfer::sdr;
+}
+
+float content_peak_nits(const AVFrame *frame)
+{
+    const AVFrameSideData *light = av_frame_get_side_data(frame, AV_FRAME_DATA_CONTENT_LIGHT_LEVEL);
+    if (light != nullptr)
+    {
+        const auto *metadata = reinterpret_cast<const AVContentLightMetadata *>(light->data);
+        if (metadata->MaxCLL > 0)
+        {
+            return static_cast<float>(metadata->MaxCLL);
+        }
+    }
+
+    const AVFrameSideData *mastering = av_frame_get_side_data(frame, AV_FRAME_DATA_MASTERING_DISPLAY_METADATA);
+    if (mastering != nullptr)
+    {
+        const auto *metadata = reinterpret_cast<const AVMasteringDisplayMetadata *>(mastering->data);
+        if (metadata->has_luminance != 0 && metadata->max_luminance.num > 0 && metadata->max_luminance.den > 0)
+        {
+            return static_cast<float>(av_q2d(metadata->max_luminance));
+        }
+    }
+    return 0.0F;
+}
+
+float sample_scale(const render_format &format)
+{
+    const float container_max = format.planes[0].bytes_per_channel == 2 ? 65535.0F : 255.0F;
+    const float stored_max = static_cast<float>(((1 << format.depth) - 1) << format.shift);
+    return container_max / stored_max;
+}
+
+int plane_extent(int size, int shift) { return (size + (1 << shift) - 1) >> shift; }
+
+GLenum plane_pixel_format(const render_plane &plane)
+{
+    if (plane.channels == 1)
+    {
+        return GL_RED;
+    }
+    return plane.channels == 2 ? GL_RG : GL_RGBA;
+}
+
+GLint plane_internal_format(const render_plane &plane)
+{
+    if (plane.bytes_per_channel == 2)
+    {
+        if (plane.channels == 1)
+        {
+            return GL_R16;
+        }
+        return plane.channels == 2 ? GL_RG16 : GL_RGBA16;
+    }
+    if (plane.channels == 1)
+    {
+        return GL_R8;
+    }
+    return plane.channels == 2 ? GL_RG8 : GL_RGBA8;
+}
+
+GLenum plane_pixel_type(const render_plane &plane) { return plane.bytes_per_channel == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE; }
+}  // namespace
+
+void video_renderer::initialize(QOpenGLContext *context)
+{
+    LOG_INFO("video renderer initialize gl");
+    initializeOpenGLFunctions();
+
+    glGenTextures(3, textures_);
+    pixel_buffer_upload_ = context->format().version() >= qMakePair(3, 0);
+    if (pixel_buffer_upload_)
+    {
+        glGenBuffers(static_cast<GLsizei>(std::size(upload_buffers_)), upload_buffers_);
+        upload_index_ = 0;
+    }
+    immutable_storage_ =
+        context->hasExtension("GL_ARB_texture_storage") || context->format().version() >= (context->isOpenGLES() ? qMakePair(3, 0) : qMakePair(4, 2));
+    gpu_timer_ = !context->isOpenGLES() && (context->format().version() >= qMakePair(3, 3) || context->hasExtension("GL_ARB_timer_query"));
+    if (gpu_timer_)
+    {
+        glGenQueries(static_cast<GLsizei>(std::size(timer_queries_)), timer_queries_);
+        std::fill(std::begin(timer_pending_), std::end(timer_pending_), false);
+        timer_index_ = 0;
+    }
+    LOG_INFO("video renderer pixel buffer upload {} immutable storage {} gpu timer {}", pixel_buffer_upload_, immutable_storage_, gpu_timer_);
+    resident_generation_ = 0;
+    tex_width_ = 0;
+    tex_height_ = 0;
+    tex_format_ = AV_PIX_FMT_NONE;
+    texture_inited_ = false;
+
+    color_matrix_ = get_color_matrix(AVCOL_SPC_BT470BG, AVCOL_RANGE_MPEG, 8);
+}
+
+void video_renderer::cleanup()
+{
+    for (QOpenGLShaderProgram *&program : programs_)
+    {
+        delete program;
+        program = nullptr;
+    }
+
+    if (textures_[0] != 0)
+    {
+        glDeleteTextures(3, textures_);
+        textures_[0] = 0;
+        textures_[1] = 0;
+        textures_[2] = 0;
+    }
+    texture_inited_ = false;
+
+    if (upload_buffers_[0] != 0)
+    {
+        glDeleteBuffers(static_cast<GLsizei>(std::size(upload_buffers_)), upload_buffers_);
+        std::fill(std::begin(upload_buffers_), std::end(upload_buffers_), 0U);
+        std::fill(std::begin(upload_buffer_sizes_), std::end(upload_buffer_sizes_), static_cast<size_t>(0));
+    }
+    pixel_buffer_upload_ = false;
+
+    if (timer_queries_[0] != 0)
+    {
+        glDeleteQueries(static_cast<GLsizei>(std::size(timer_queries_)), timer_queries_);
+        std::fill(std::begin(timer_queries_), std::end(timer_queries_), 0U);
+        std::fill(std::begin(timer_pending_), std::end(timer_pending_), false);
+    }
+    gpu_timer_ = false;
+
+    tex_width_ = 0;
+    tex_height_ = 0;
+    tex_format_ = AV_PIX_FMT_NONE;
+    resident_generation_ = 0;
+}
+
+video_renderer::upload_stats video_renderer::upload_timing() const
+{
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return upload_stats_;
+}
+
+video_renderer::paint_stats video_renderer::paint_timing() const
+{
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return paint_stats_;
+}
+
+QOpenGLShaderProgram *video_renderer::shader_program(render_shader shader, render_transfer transfer)
+{
+    QOpenGLShaderProgram *&program = programs_[(static_cast<size_t>(shader) * k_render_transfer_count) + static_cast<size_t>(transfer)];
+    if (program != nullptr)
+    {
+        return program;
+    }
+
+    program = new QOpenGLShaderProgram();
+    program->addShaderFromSourceCode(QOpenGLShader::Vertex, k_vertex_shader);
+    program->addShaderFromSourceCode(QOpenGLShader::Fragment, QString(k_fragment_header) + fragment_sample(shader) + fragment_output(transfer) + "}\n");
+    if (!program->link())
+    {
+        LOG_ERROR("video renderer shader link failed shader {} transfer {}", static_cast<int>(shader), static_cast<int>(transfer));
+    }
+    else
+    {
+        LOG_INFO("video renderer shader linked successfully shader {} transfer {}", static_cast<int>(shader), static_cast<int>(transfer));
+    }
+    return program;
+}
+
+void video_renderer::allocate_textures(const AVFrame *frame, const render_format &format)
+{
+    tex_width_ = frame->width;
+    tex_height_ = frame->height;
+    tex_format_ = frame->format;
+    LOG_INFO("video renderer texture resize to {}x{} format {}", tex_width_, tex_height_, av_get_pix_fmt_name(format.format));
+    resident_generation_ = 0;
+
+    if (immutable_storage_ && texture_inited_)
+    {
+        glDeleteTextures(3, textures_);
+        glGenTextures(3, textures_);
+    }
+
+    for (int i = 0; i < format.plane_count; i++)
+    {
+        const render_plane &plane = format.planes[i];
+        const int plane_width = plane_extent(tex_width_, plane.width_shift);
+        const int plane_height = plane_extent(tex_height_, plane.height_shift);
+        glBindTexture(GL_TEXTURE_2D, textures_[i]);
+        if (immutable_storage_)
+        {
+            glTexStorage2D(GL_TEXTURE_2D, 1, static_cast<GLenum>(plane_internal_format(plane)), plane_width, plane_height);
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_2D,
+                         0,
+                         plane_internal_format(plane),
+                         plane_width,
+                         plane_height,
+                         0,
+                         plane_pixel_format(plane),
+                         plane_pixel_type(plane),
+                         nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    texture_inited_ = true;
+}
+
+void video_renderer::upload_planes(const AVFrame *frame, const render_format &format)
+{
+    QElapsedTimer timer;
+    timer.start();
+    if (pixel_buffer_upload_ && upload_through_buffer(frame, format))
+    {
+        record_upload(timer.nsecsElapsed() / 1000, true);
+        return;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < format.plane_count; i++)
+    {
+        const render_plane &plane = format.planes[i];
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures_[i]);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, frame->linesize[i] / (plane.channels * plane.bytes_per_channel));
+        glTexSubImage2D(GL_TEXTURE_2D,
+                        0,
+                        0,
+                        0,
+                        plane_extent(tex_width_, plane.width_shift),
+                        plane_extent(tex_height_, plane.height_shift),
+                        plane_pixel_format(plane),
+                        plane_pixel_type(plane),
+                        frame->data[i]);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    record_upload(timer.nsecsElapsed() / 1000, false);
+}
+
+bool video_renderer::upload_through_buffer(const AVFrame *frame, const render_format &format)
+{
+    size_t offsets[3] = {0, 0, 0};
+    size_t plane_bytes[3] = {0, 0, 0};
+    size_t total = 0;
+    for (int i = 0; i < format.plane_count; i++)
+    {
+        if (frame->linesize[i] <= 0)
+        {
+            return false;
+        }
+        offsets[i] = total;
+        plane_bytes[i] = static_cast<size_t>(frame->linesize[i]) * static_cast<size_t>(plane_extent(tex_height_, format.planes[i].height_shift));
+        total += plane_bytes[i];
+    }
+
+    const size_t slot = upload_index_;
+    upload_index_ = (upload_index_ + 1) % std::size(upload_buffers_);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload_buffers_[slot]);
+    if (upload_buffer_sizes_[slot] < total)
+    {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(total), nullptr, GL_STREAM_DRAW);
+        upload_buffer_sizes_[slot] = total;
+    }
+
+    void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(total), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped == nullptr)
+    {
+        LOG_WARN("video renderer pixel buffer map failed falling back to direct upload");
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        pixel_buffer_upload_ = false;
+        return false;
+    }
+    for (int i = 0; i < format.plane_count; i++)
+    {
+        std::memcpy(static_cast<uint8_t *>(mapped) + offsets[i], frame->data[i], plane_bytes[i]);
+    }
+    if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+    {
+        LOG_WARN("video renderer pixel buffer contents lost during upload");
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < format.plane_count; i++)
+    {
+        const render_plane &plane = format.planes[i];
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures_[i]);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, frame->linesize[i] / (plane.channels * plane.bytes_per_channel));
+        glTexSubImage2D(GL_TEXTURE_2D,
+                        0,
+                        0,
+                        0,
+                        plane_extent(tex_width_, plane.width_shift),
+                        plane_extent(tex_height_, plane.height_shift),
+                        plane_pixel_format(plane),
+                        plane_pixel_type(plane),
+                        reinterpret_cast<const void *>(offsets[i]));
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return true;
+}
+
+void video_renderer::record_upload(int64_t elapsed_us, bool pixel_buffers)
+{
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    upload_stats_.uploads++;
+    upload_stats_.last_us = elapsed_us;
+    upload_stats_.pixel_buffers = pixel_buffers;
+    upload_stats_.average_us = upload_stats_.uploads == 1 ? static_cast<double>(elapsed_us) : (upload_stats_.average_us * 0.9) + (static_cast<double>(elapsed_us) * 0.1);
+    if (upload_stats_.uploads % k_upload_log_interval == 0)
+    {
+        LOG_DEBUG("video renderer upload avg {:.0f} us last {} us pixel buffers {}", upload_stats_.average_us, elapsed_us, pixel_buffers);
+    }
+}
+
+bool video_renderer::begin_gpu_timer()
+{
+    if (!gpu_timer_ || timer_pending_[timer_index_])
+    {
+        return false;
+    }
+    glBeginQuery(k_gl_time_elapsed, timer_queries_[timer_index_]);
+    return true;
+}
+
+void video_renderer::end_gpu_timer()
+{
+    glEndQuery(k_gl_time_elapsed);
+    timer_pending_[timer_index_] = true;
+    timer_index_ = (timer_index_ + 1) % std::size(timer_queries_);
+}
+
+void video_renderer::collect_gpu_timers()
+{
+    for (size_t i = 0; i < std::size(timer_queries_); i++)
+    {
+        if (!timer_pending_[i])
+        {
+            continue;
+        }
+
+        GLuint available = 0;
+        glGetQueryObjectuiv(timer_queries_[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0)
+        {
+            continue;
+        }
+
+        GLuint elapsed_ns = 0;
+        glGetQueryObjectuiv(timer_queries_[i], GL_QUERY_RESULT, &elapsed_ns);
+        timer_pending_[i] = false;
+        record_gpu_time(static_cast<int64_t>(elapsed_ns / 1000));
+    }
+}
+
+void video_renderer::record_paint(int64_t elapsed_us)
+{
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    paint_stats_.paints++;
+    paint_stats_.last_us = elapsed_us;
+    paint_stats_.average_us = paint_stats_.paints == 1 ? static_cast<double>(elapsed_us) : (paint_stats_.average_us * 0.9) + (static_cast<double>(elapsed_us) * 0.1);
+    paint_window_peak_us_ = std::max(paint_window_peak_us_, elapsed_us);
+    paint_stats_.peak_us = std::max(paint_stats_.peak_us, elapsed_us);
+    if (paint_stats_.paints % k_paint_log_interval == 0)
+    {
+        LOG_DEBUG("video renderer paint avg {:.0f} us peak {} us gpu avg {:.0f} us", paint_stats_.average_us, paint_window_peak_us_, paint_stats_.gpu_average_us);
+        paint_stats_.peak_us = paint_window_peak_us_;
+        paint_window_peak_us_ = 0;
+    }
+}
+
+void video_renderer::record_gpu_time(int64_t elapsed_us)
+{
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    paint_stats_.gpu_average_us = !paint_stats_.gpu_timer ? static_cast<double>(elapsed_us) : (paint_stats_.gpu_average_us * 0.9) + (static_cast<double>(elapsed_us) * 0.1);
+    paint_stats_.gpu_last_us = elapsed_us;
+    paint_stats_.gpu_timer = true;
+}
+
+void video_renderer::render(const std::shared_ptr<media_frame> &frame, uint64_t generation, QSize drawable)
+{
+    QElapsedTimer timer;
+    timer.start();
+    collect_gpu_timers();
+    const bool gpu_timed = begin_gpu_timer();
+    draw(frame, generation, drawable);
+    if (gpu_timed)
+    {
+        end_gpu_timer();
+    }
+    record_paint(timer.nsecsElapsed() / 1000);
+}
+
+void video_renderer::draw(const std::shared_ptr<media_frame> &frame, uint64_t generation, QSize drawable)
+{
+    glViewport(0, 0, drawable.width(), drawable.height());
+    glClearColor(0.0F, 0.0F, 0.0F, 1.0F);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (frame == nullptr || frame->raw() == nullptr)
+    {
+        return;
+    }
+
+    auto *raw = frame->raw();
+    const render_format *format = find_render_format(raw->format);
+    if (format == nullptr)
+    {
+        LOG_WARN("video renderer cannot sample pixel format {}", raw->format);
+        return;
+    }
+
+    if (resident_generation_ != generation)
+    {
+        update_color_matrix(raw);
+    }
+
+    const bool packed = format->shader == render_shader::packed_rgb || format->shader == render_shader::packed_bgr;
+    QOpenGLShaderProgram *program = shader_program(format->shader, packed ? render_transfer::sdr : current_transfer_);
+    if (!program->bind())
+    {
+        LOG_ERROR("video renderer failed to bind shader program");
+        return;
+    }
+
+    if (raw->width != tex_width_ || raw->height != tex_height_ || raw->format != tex_format_)
+    {
+        allocate_textures(raw, *format);
+    }
+
+    if (resident_generation_ != generation)
+    {
+        upload_planes(raw, *format);
+        resident_generation_ = generation;
+    }
+    for (int i = 0; i < format->plane_count; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures_[i]);
+        program->setUniformValue(k_texture_uniforms[i], i);
+    }
+    program->setUniformValue("colorMatrix", color_matrix_);
+    program->setUniformValue("sampleScale", sample_scale(*format));
+    program->setUniformValue("peakLuminance", std::max(hdr_peak_nits_, k_sdr_white_nits) / k_sdr_white_nits);
+    program->setUniformValue("gamutMatrix", gamut_matrix_);
+
+    const int drawable_width = std::max(drawable.width(), 1);
+    const int drawable_height = std::max(drawable.height(), 1);
+    const display_rect rect = calculate_display_rect(drawable_width, drawable_height, tex_width_, tex_height_, raw->sample_aspect_ratio);
+
+    const GLfloat x_scale = static_cast<GLfloat>(static_cast<double>(rect.width) / static_cast<double>(drawable_width));
+    const GLfloat y_scale = static_cast<GLfloat>(static_cast<double>(rect.height) / static_cast<double>(drawable_height));
+
+    const GLfloat vertices[] = {-x_scale, -y_scale, x_scale, -y_scale, -x_scale, y_scale, x_scale, y_scale};
+    static const GLfloat texCoords[] = {0.0F, 1.0F, 1.0F, 1.0F, 0.0F, 0.0F, 1.0F, 0.0F};
+
+    const int posLoc = program->attributeLocation("position");
+    program->enableAttributeArray(posLoc);
+    program->setAttributeArray(posLoc, vertices, 2);
+
+    const int texLoc = program->attributeLocation("texCoord");
+    program->enableAttributeArray(texLoc);
+    program->setAttributeArray(texLoc, texCoords, 2);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    program->disableAttributeArray(posLoc);
+    program->disableAttributeArray(texLoc);
+    program->release();
+}
+
+void video_renderer::update_color_matrix(const AVFrame *frame)
+{
+    AVColorSpace space = frame->colorspace;
+    AVColorRange range = frame->color_range;
+    const int width = frame->width;
+    const int height = frame->height;
+
+    if (space == AVCOL_SPC_UNSPECIFIED)
+    {
+        if (width >= 1280 || height >= 720)
+        {
+            space = AVCOL_SPC_BT709;
+        }
+        else
+        {
+            space = AVCOL_SPC_BT470BG;
+        }
+    }
+
+    if (range == AVCOL_RANGE_UNSPECIFIED)
+    {
+        range = AVCOL_RANGE_MPEG;
+    }
+
+    const render_format *format = find_render_format(frame->format);
+    const int depth = format != nullptr ? format->depth : 8;
+    const AVColorTransferCharacteristic trc = frame->color_trc;
+    const AVColorPrimaries primaries = frame->color_primaries;
+
+    const float peak = content_peak_nits(frame);
+    if (peak > 0.0F && peak != hdr_peak_nits_)
+    {
+        LOG_INFO("video renderer hdr peak luminance {} nits", peak);
+        hdr_peak_nits_ = peak;
+    }
+
+    if (space == current_color_space_ && range == current_color_range_ && depth == current_depth_ && trc == current_color_trc_ &&
+        primaries == current_color_primaries_)
+    {
+        return;
+    }
+
+    if (trc != current_color_trc_ && peak <= 0.0F)
+    {
+        hdr_peak_nits_ = k_default_hdr_peak_nits;
+    }
+
+    current_color_space_ = space;
+    current_color_range_ = range;
+    current_depth_ = depth;
+    current_color_trc_ = trc;
+    current_color_primaries_ = primaries;
+    current_transfer_ = transfer_for(trc);
+    LOG_INFO("video renderer updating color matrix space {} range {} depth {} transfer {} primaries {}",
+             av_color_space_name(space),
+             av_color_range_name(range),
+             depth,
+             av_color_transfer_name(trc),
+             av_color_primaries_name(primaries));
+    color_matrix_ = get_color_matrix(space, range, depth);
+    gamut_matrix_ = primaries == AVCOL_PRI_BT2020 ? QMatrix3x3(k_bt2020_to_bt709) : QMatrix3x3();
+}
+
+QMatrix4x4 video_renderer::get_color_matrix(AVColorSpace space, AVColorRange range, int depth)
+{
+    QMatrix4x4 mat;
+
+    float kr = 0.299F;
+    float kb = 0.114F;
+
+    if (space == AVCOL_SPC_BT709)
+    {
+        kr = 0.2126F;
+        kb = 0.0722F;
+    }
+    else if (space == AVCOL_SPC_BT2020_NCL || space == AVCOL_SPC_BT2020_CL)
+    {
+        kr = 0.2627F;
+        kb = 0.0593F;
+    }
+
+    const float kg = 1.0F - kr - kb;
+
+    const float code_scale = static_cast<float>(1 << (depth - 8));
+    const float code_max = static_cast<float>((1 << depth) - 1);
+    float y_off = 0.0F;
+    float uv_off = 128.0F * code_scale / code_max;
+    float y_scale = 1.0F;
+    float uv_scale = 1.0F;
+
+    if (range == AVCOL_RANGE_MPEG)
+    {
+        y_off = 16.0F * code_scale / code_max;
+        y_scale = code_max / ((235.0F - 16.0F) * code_scale);
+        uv_scale = code_max / ((240.0F - 16.0F) * code_scale);
+    }
+
+    const float r_v = 2.0F * (1.0F - kr);
+    const float b_u = 2.0F * (1.0F - kb);
+    const float g_u = -(b_u * kb) / kg;
+    const float g_v = -(r_v * kr) / kg;
+
+    const float r_y_coeff = y_scale;
+    const float r_v_coeff = r_v * uv_scale;
+    const float r_const = -(y_scale * y_off) - (r_v * uv_scale * uv_off);
+
+    const float g_y_coeff = y_scale;
+    const float g_u_coeff = g_u * uv_scale;
+    const float g_v_coeff = g_v * uv_scale;
+    const float g_const = -(y_scale * y_off) - (g_u * uv_scale * uv_off) - (g_v * uv_scale * uv_off);
+
+    const float b_y_coeff = y_scale;
+    const float b_u_coeff = b_u * uv_scale;
+    const float b_const = -(y_scale * y_off) - (b_u * uv_scale * uv_off);
+
+    mat.setRow(0, QVector4D(r_y_coeff, 0.0F, r_v_coeff, r_const));
+    mat.setRow(1, QVector4D(g_y_coeff, g_u_coeff, g_v_coeff, g_const));
+    mat.setRow(2, QVector4D(b_y_coeff, b_u_coeff, 0.0F, b_const));
+    mat.setRow(3, QVector4D(0.0F, 0.0F, 0.0F, 1.0F));
+
+    return mat;
+}
@@ -0,0 +1,105 @@
+#ifndef VIDEO_RENDERER_H
+#define VIDEO_RENDERER_H
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+#include <QMatrix4x4>
+#include <QGenericMatrix>
+#include <QSize>
+#include "media_objects.h"
+#include "render_format.h"
+
+extern "C"
+{
+#include <libavutil/pixfmt.h>
+#include "libavutil/pixdesc.h"
+}
+
+class video_renderer : protected QOpenGLExtraFunctions
+{
+   public:
+    struct upload_stats
+    {
+        uint64_t uploads = 0;
+        int64_t last_us = 0;
+        double average_us = 0.0;
+        bool pixel_buffers = false;
+    };
+
+    struct paint_stats
+    {
+        uint64_t paints = 0;
+        int64_t last_us = 0;
+        double average_us = 0.0;
+        int64_t peak_us = 0;
+        bool gpu_timer = false;
+        int64_t gpu_last_us = 0;
+        double gpu_average_us = 0.0;
+    };
+
+   public:
+    video_renderer() = default;
+    ~video_renderer() = default;
+    video_renderer(const video_renderer &) = delete;
+    video_renderer &operator=(const video_renderer &) = delete;
+
+   public:
+    void initialize(QOpenGLContext *context);
+    void cleanup();
+    void render(const std::shared_ptr<media_frame> &frame, uint64_t generation, QSize drawable);
+    [[nodiscard]] upload_stats upload_timing() const;
+    [[nodiscard]] paint_stats paint_timing() const;
+
+   private:
+    void draw(const std::shared_ptr<media_frame> &frame, uint64_t generation, QSize drawable);
+    bool begin_gpu_timer();
+    void end_gpu_timer();
+    void collect_gpu_timers();
+    void record_paint(int64_t elapsed_us);
+    void record_gpu_time(int64_t elapsed_us);
+    QOpenGLShaderProgram *shader_program(render_shader shader, render_transfer transfer);
+    void allocate_textures(const AVFrame *frame, const render_format &format);
+    void upload_planes(const AVFrame *frame, const render_format &format);
+    bool upload_through_buffer(const AVFrame *frame, const render_format &format);
+    void record_upload(int64_t elapsed_us, bool pixel_buffers);
+    void update_color_matrix(const AVFrame *frame);
+    static QMatrix4x4 get_color_matrix(AVColorSpace space, AVColorRange range, int depth);
+
+   private:
+    int tex_width_ = 0;
+    int tex_height_ = 0;
+    int tex_format_ = AV_PIX_FMT_NONE;
+    GLuint textures_[3] = {0, 0, 0};
+    bool texture_inited_ = false;
+    bool immutable_storage_ = false;
+    uint64_t resident_generation_ = 0;
+    GLuint upload_buffers_[3] = {0, 0, 0};
+    size_t upload_buffer_sizes_[3] = {0, 0, 0};
+    size_t upload_index_ = 0;
+    bool pixel_buffer_upload_ = false;
+    mutable std::mutex stats_mutex_;
+    upload_stats upload_stats_;
+    paint_stats paint_stats_;
+    int64_t paint_window_peak_us_ = 0;
+    GLuint timer_queries_[3] = {0, 0, 0};
+    bool timer_pending_[3] = {false, false, false};
+    size_t timer_index_ = 0;
+    bool gpu_timer_ = false;
+    std::array<QOpenGLShaderProgram *, static_cast<size_t>(k_render_shader_count) * k_render_transfer_count> programs_{};
+
+    AVColorSpace current_color_space_ = AVCOL_SPC_UNSPECIFIED;
+    AVColorRange current_color_range_ = AVCOL_RANGE_UNSPECIFIED;
+    AVColorTransferCharacteristic current_color_trc_ = AVCOL_TRC_UNSPECIFIED;
+    AVColorPrimaries current_color_primaries_ = AVCOL_PRI_UNSPECIFIED;
+    int current_depth_ = 8;
+    render_transfer current_transfer_ = render_transfer::sdr;
+    float hdr_peak_nits_ = 0.0F;
+    QMatrix4x4 color_matrix_;
+    QMatrix3x3 gamut_matrix_;
+};
+
+#endif
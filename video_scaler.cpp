@@ -1,10 +1,30 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "log.h"
 #include "video_scaler.h"
 extern "C"
 {
 #include <libswscale/swscale.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/opt.h>
 }
 
+namespace
+{
+constexpr int64_t k_pixels_per_thread = static_cast<int64_t>(1280) * 720;
+constexpr int k_max_threads = 8;
+constexpr uint64_t k_convert_log_interval = 600;
+
+int thread_count_for(int width, int height)
+{
+    const int64_t pixels = static_cast<int64_t>(width) * height;
+    const int hardware = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    const auto wanted = static_cast<int>((pixels + k_pixels_per_thread - 1) / k_pixels_per_thread);
+    return std::clamp(wanted, 1, std::min(hardware, k_max_threads));
+}
+}  // namespace
+
 video_scaler::~video_scaler()
 {
     if (sws_ctx_ != nullptr)
@@ -13,7 +33,67 @@ video_scaler::~video_scaler()
     }
 }
 
-bool video_scaler::convert(const AVFrame *src, AVFrame *dst)
+SwsContext *video_scaler::create_context(const AVFrame *src, const AVFrame *dst, int flags)
+{
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 1, 100)
+    threads_ = thread_count_for(std::max(src->width, dst->width), std::max(src->height, dst->height));
+    if (threads_ > 1)
+    {
+        SwsContext *ctx = sws_alloc_context();
+        if (ctx != nullptr && av_opt_set_int(ctx, "srcw", src->width, 0) >= 0 && av_opt_set_int(ctx, "srch", src->height, 0) >= 0 &&
+            av_opt_set_int(ctx, "src_format", src->format, 0) >= 0 && av_opt_set_int(ctx, "dstw", dst->width, 0) >= 0 &&
+            av_opt_set_int(ctx, "dsth", dst->height, 0) >= 0 && av_opt_set_int(ctx, "dst_format", dst->format, 0) >= 0 &&
+            av_opt_set_int(ctx, "sws_flags", flags, 0) >= 0 && av_opt_set_int(ctx, "threads", threads_, 0) >= 0 &&
+            sws_init_context(ctx, nullptr, nullptr) >= 0)
+        {
+            LOG_INFO("video scaler slice threaded context {}x{} -> {}x{} threads {}", src->width, src->height, dst->width, dst->height, threads_);
+            return ctx;
+        }
+
+        LOG_WARN("video scaler slice threading unavailable falling back to single thread");
+        sws_freeContext(ctx);
+    }
+#endif
+    threads_ = 1;
+    return sws_getContext(src->width,
+                          src->height,
+                          static_cast<AVPixelFormat>(src->format),
+                          dst->width,
+                          dst->height,
+                          static_cast<AVPixelFormat>(dst->format),
+                          flags,
+                          nullptr,
+                          nullptr,
+                          nullptr);
+}
+
+bool video_scaler::scale(const AVFrame *src, AVFrame *dst)
+{
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 1, 100)
+    if (threads_ > 1)
+    {
+        const AVColorSpace colorspace = dst->colorspace;
+        const AVColorRange color_range = dst->color_range;
+        const AVColorPrimaries color_primaries = dst->color_primaries;
+        const AVColorTransferCharacteristic color_trc = dst->color_trc;
+        if (sws_scale_frame(sws_ctx_, dst, src) < 0)
+        {
+            return false;
+        }
+        if (dst->format != src->format)
+        {
+            dst->colorspace = colorspace;
+            dst->color_range = color_range;
+            dst->color_primaries = color_primaries;
+            dst->color_trc = color_trc;
+        }
+        return true;
+    }
+#endif
+    return sws_scale(sws_ctx_, src->data, src->linesize, 0, src->height, dst->data, dst->linesize) > 0;
+}
+
+bool video_scaler::convert(const AVFrame *src, AVFrame *dst, int flags)
 {
     if (src == nullptr || dst == nullptr)
     {
@@ -21,23 +101,14 @@ bool video_scaler::convert(const AVFrame *src, AVFrame *dst)
     }
 
     if (sws_ctx_ == nullptr || src->width != src_w_ || src->height != src_h_ || src->format != src_fmt_ || dst->width != dst_w_ ||
-        dst->height != dst_h_ || dst->format != dst_fmt_)
+        dst->height != dst_h_ || dst->format != dst_fmt_ || flags != flags_)
     {
         if (sws_ctx_ != nullptr)
         {
             sws_freeContext(sws_ctx_);
         }
 
-        sws_ctx_ = sws_getContext(src->width,
-                                  src->height,
-                                  static_cast<AVPixelFormat>(src->format),
-                                  dst->width,
-                                  dst->height,
-                                  static_cast<AVPixelFormat>(dst->format),
-                                  SWS_BILINEAR,
-                                  nullptr,
-                                  nullptr,
-                                  nullptr);
+        sws_ctx_ = create_context(src, dst, flags);
 
         if (sws_ctx_ == nullptr)
         {
@@ -50,12 +121,39 @@ bool video_scaler::convert(const AVFrame *src, AVFrame *dst)
         dst_w_ = dst->width;
         dst_h_ = dst->height;
         dst_fmt_ = dst->format;
+        flags_ = flags;
     }
 
-    sws_scale(sws_ctx_, src->data, src->linesize, 0, src->height, dst->data, dst->linesize);
+    const auto start = std::chrono::steady_clock::now();
+    if (!scale(src, dst))
+    {
+        return false;
+    }
+    record_conversion(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
 
     dst->pts = src->pts;
     dst->sample_aspect_ratio = src->sample_aspect_ratio;
 
     return true;
 }
+
+void video_scaler::record_conversion(int64_t elapsed_us)
+{
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.threads = threads_;
+    stats_.conversions++;
+    stats_.last_us = elapsed_us;
+    stats_.max_us = std::max(stats_.max_us, elapsed_us);
+    stats_.average_us = stats_.conversions == 1 ? static_cast<double>(elapsed_us) : (stats_.average_us * 0.9) + (static_cast<double>(elapsed_us) * 0.1);
+    if (stats_.conversions % k_convert_log_interval == 0)
+    {
+        LOG_DEBUG("video scaler {}x{} -> {}x{} threads {} avg {:.0f} us max {} us", src_w_, src_h_, dst_w_, dst_h_, threads_, stats_.average_us, stats_.max_us);
+        stats_.max_us = 0;
+    }
+}
+
+video_scaler::stats video_scaler::read() const
+{
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
@@ -1,6 +1,8 @@
 #ifndef VIDEO_SCALER_H
 #define VIDEO_SCALER_H
 
+#include <cstdint>
+#include <mutex>
 #include "media_objects.h"
 
 extern "C"
@@ -10,12 +12,28 @@ extern "C"
 
 class video_scaler
 {
+   public:
+    struct stats
+    {
+        int threads = 1;
+        uint64_t conversions = 0;
+        int64_t last_us = 0;
+        int64_t max_us = 0;
+        double average_us = 0.0;
+    };
+
    public:
     video_scaler() = default;
     ~video_scaler();
 
    public:
-    bool convert(const AVFrame *src, AVFrame *dst);
+    bool convert(const AVFrame *src, AVFrame *dst, int flags = SWS_BILINEAR);
+    [[nodiscard]] stats read() const;
+
+   private:
+    SwsContext *create_context(const AVFrame *src, const AVFrame *dst, int flags);
+    bool scale(const AVFrame *src, AVFrame *dst);
+    void record_conversion(int64_t elapsed_us);
 
    private:
     int src_w_ = 0;
@@ -24,7 +42,11 @@ class video_scaler
     int dst_h_ = 0;
     int src_fmt_ = -1;
     int dst_fmt_ = -1;
+    int flags_ = 0;
+    int threads_ = 1;
     SwsContext *sws_ctx_ = nullptr;
+    mutable std::mutex stats_mutex_;
+    stats stats_;
 };
 
 #endif
@@ -1,13 +1,56 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
 #include "log.h"
 #include "video_sync_thread.h"
+#include "render_format.h"
+
+namespace
+{
+using steady_clock = std::chrono::steady_clock;
+
+constexpr double k_video_master_resync_threshold = 0.1;
+constexpr auto k_max_sleep_slice = std::chrono::milliseconds(50);
+constexpr auto k_spin_window = std::chrono::microseconds(1500);
+constexpr uint64_t k_present_log_interval = 600;
+constexpr uint64_t k_drop_log_interval = 100;
+constexpr double k_default_frame_duration = 0.04;
+constexpr double k_shallow_queue_late_frames = 2.0;
+constexpr double k_max_frame_duration = 10.0;
+constexpr size_t k_frame_cache_bytes = static_cast<size_t>(256) * 1024 * 1024;
+constexpr size_t k_playback_cache_frames = 4;
+constexpr size_t k_reverse_frame_budget = 48;
+constexpr double k_reverse_spill_scale = 0.5;
+constexpr size_t k_reverse_spill_bytes = static_cast<size_t>(256) * 1024 * 1024;
+constexpr double k_reverse_seek_margin = 0.001;
+constexpr double k_reverse_max_gap = 0.5;
+constexpr auto k_reverse_poll = std::chrono::milliseconds(5);
+constexpr auto k_reverse_collect_timeout = std::chrono::seconds(2);
+constexpr double k_trick_max_gap = 0.25;
+constexpr double k_downscale_threshold = 0.75;
+constexpr double k_downscale_steps = 32.0;
+
+bool renderer_samples_directly(const AVFrame *frame)
+{
+    return find_render_format(frame->format) != nullptr && frame->hw_frames_ctx == nullptr && frame->buf[0] != nullptr && frame->width > 0 && frame->height > 0;
+}
+}  // namespace
 
 video_sync_thread::video_sync_thread(safe_queue<std::shared_ptr<media_frame>> *frame_queue,
                                      safe_queue<std::shared_ptr<media_packet>> *packet_queue,
                                      AVRational tb,
                                      av_clock *clk,
                                      QObject *parent)
-    : QThread(parent), clock_(clk), time_base_(tb), frame_queue_(frame_queue), packet_queue_(packet_queue)
+    : QThread(parent),
+      clock_(clk),
+      time_base_(tb),
+      render_frame_(std::make_shared<media_frame>()),
+      cache_(k_frame_cache_bytes),
+      frame_queue_(frame_queue),
+      packet_queue_(packet_queue)
 {
+    cache_.set_frame_limit(k_playback_cache_frames);
     LOG_INFO("video sync thread created");
 }
 
@@ -22,22 +65,727 @@ void video_sync_thread::paused(bool p)
 {
     LOG_INFO("video sync thread paused state {}", p);
     paused_.store(p);
+    cache_.set_frame_limit(p ? std::numeric_limits<size_t>::max() : k_playback_cache_frames);
+}
+
+void video_sync_thread::set_vsync_pacer(vsync_pacer *pacer) { vsync_pacer_ = pacer; }
+
+video_sync_thread::frame_drop_stats video_sync_thread::frame_drops() const
+{
+    frame_drop_stats stats;
+    stats.stale = stale_drops_.load();
+    stats.late = late_drops_.load();
+    stats.cadence = cadence_drops_.load();
+    return stats;
+}
+
+const present_histogram &video_sync_thread::present_errors() const { return present_errors_; }
+
+void video_sync_thread::record_present_error(int64_t error_us)
+{
+    present_errors_.record(error_us);
+
+    const present_histogram::snapshot stats = present_errors_.read();
+    if (stats.count % k_present_log_interval == 0)
+    {
+        LOG_INFO("video present error frames {} mean {:.0f} us p50 <{} us p99 <{} us max {} us",
+                 stats.count,
+                 stats.mean_error_us,
+                 present_histogram::percentile_upper_us(stats, 0.5),
+                 present_histogram::percentile_upper_us(stats, 0.99),
+                 stats.max_error_us);
+    }
+}
+
+void video_sync_thread::count_drop(drop_reason reason, double pts, double diff)
+{
+    const char *name = "stale";
+    switch (reason)
+    {
+        case drop_reason::stale:
+            stale_drops_.fetch_add(1);
+            break;
+        case drop_reason::late:
+            late_drops_.fetch_add(1);
+            name = "late";
+            break;
+        case drop_reason::cadence:
+            cadence_drops_.fetch_add(1);
+            name = "cadence";
+            break;
+    }
+    LOG_DEBUG("dropping video frame pts {:.3f} diff {:.3f} reason {} queue {}/{}", pts, diff, name, frame_queue_->size(), frame_queue_->max_size());
+
+    const frame_drop_stats stats = frame_drops();
+    const uint64_t total = stats.stale + stats.late + stats.cadence;
+    if (total % k_drop_log_interval == 0)
+    {
+        LOG_INFO("video frame drops total {} stale {} late {} cadence {}", total, stats.stale, stats.late, stats.cadence);
+    }
+}
+
+double video_sync_thread::frame_duration(const AVFrame *frame, double pts) const
+{
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 30, 100)
+    const int64_t duration = frame->duration;
+#else
+    const int64_t duration = frame->pkt_duration;
+#endif
+    if (duration > 0)
+    {
+        const double seconds = static_cast<double>(duration) * av_q2d(time_base_);
+        if (seconds < k_max_frame_duration)
+        {
+            return seconds;
+        }
+    }
+    if (last_pts_ >= 0.0 && pts > last_pts_ && pts - last_pts_ < k_max_frame_duration)
+    {
+        return pts - last_pts_;
+    }
+    return last_duration_ > 0.0 ? last_duration_ : k_default_frame_duration;
+}
+
+bool video_sync_thread::should_drop_late(double pts, double duration, int serial)
+{
+    if (clock_->serial() != serial || frame_queue_->empty())
+    {
+        return false;
+    }
+
+    const double lateness = clock_->get() - pts;
+    if (lateness <= duration)
+    {
+        return false;
+    }
+    return frame_queue_->size() > frame_queue_->max_size() / 2 || lateness > duration * k_shallow_queue_late_frames;
+}
+
+double video_sync_thread::frame_pts(const media_frame &frame) const
+{
+    const AVFrame *decoded_frame = frame.raw();
+    int64_t timestamp = decoded_frame->pts;
+    if (timestamp == AV_NOPTS_VALUE)
+    {
+        timestamp = decoded_frame->best_effort_timestamp;
+    }
+    return timestamp == AV_NOPTS_VALUE ? clock_->get() : static_cast<double>(timestamp) * av_q2d(time_base_);
+}
+
+bool video_sync_thread::is_keyframe(const AVFrame *frame)
+{
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(58, 7, 100)
+    return (frame->flags & AV_FRAME_FLAG_KEY) != 0;
+#else
+    return frame->key_frame != 0;
+#endif
+}
+
+void video_sync_thread::set_display_size(int width, int height)
+{
+    const bool width_changed = display_width_.exchange(width) != width;
+    const bool height_changed = display_height_.exchange(height) != height;
+    if (width_changed || height_changed)
+    {
+        display_resized_.store(true);
+    }
+}
+
+bool video_sync_thread::downscale_target(const AVFrame *frame, int &width, int &height) const
+{
+    const int display_width = display_width_.load();
+    const int display_height = display_height_.load();
+    if (display_width <= 0 || display_height <= 0 || frame->width <= 0 || frame->height <= 0)
+    {
+        return false;
+    }
+
+    const double sar = frame->sample_aspect_ratio.num > 0 && frame->sample_aspect_ratio.den > 0 ? av_q2d(frame->sample_aspect_ratio) : 1.0;
+    const double fit = std::min(static_cast<double>(display_width) / (frame->width * sar), static_cast<double>(display_height) / frame->height);
+    const double scale = std::ceil(fit * k_downscale_steps) / k_downscale_steps;
+    if (scale > k_downscale_threshold)
+    {
+        return false;
+    }
+
+    width = std::max(2, static_cast<int>(std::lround(frame->width * scale)) & ~1);
+    height = std::max(2, static_cast<int>(std::lround(frame->height * scale)) & ~1);
+    return true;
+}
+
+std::shared_ptr<media_frame> video_sync_thread::convert_frame(const media_frame &frame)
+{
+    int target_width = frame.raw()->width;
+    int target_height = frame.raw()->height;
+    const bool downscale = downscale_target(frame.raw(), target_width, target_height);
+    const bool renderable = renderer_samples_directly(frame.raw());
+    const bool passthrough = renderable && !downscale;
+    if (passthrough != passthrough_ || target_width != output_width_ || target_height != output_height_)
+    {
+        LOG_INFO("video sync {} frames format {} size {}x{} to {}x{}",
+                 passthrough ? "passing through" : (downscale ? "downscaling" : "converting"),
+                 frame.raw()->format,
+                 frame.raw()->width,
+                 frame.raw()->height,
+                 target_width,
+                 target_height);
+        passthrough_ = passthrough;
+        output_width_ = target_width;
+        output_height_ = target_height;
+    }
+
+    if (passthrough)
+    {
+        auto shared = std::make_shared<media_frame>();
+        if (av_frame_ref(shared->raw(), frame.raw()) < 0)
+        {
+            LOG_ERROR("video sync av frame ref failed");
+            return nullptr;
+        }
+        convert_cost_ = (convert_cost_ * 7) / 8;
+        return shared;
+    }
+
+    const int target_format = renderable ? frame.raw()->format : AV_PIX_FMT_YUV420P;
+    auto *raw_frame = render_frame_->raw();
+    if (raw_frame->width != target_width || raw_frame->height != target_height || raw_frame->format != target_format)
+    {
+        av_frame_unref(raw_frame);
+        raw_frame->format = target_format;
+        raw_frame->width = target_width;
+        raw_frame->height = target_height;
+        if (av_frame_get_buffer(raw_frame, 32) < 0)
+        {
+            LOG_ERROR("video sync av frame get buffer failed");
+            return nullptr;
+        }
+    }
+
+    const auto convert_start = steady_clock::now();
+    if (!scaler_.convert(frame.raw(), raw_frame, downscale ? SWS_BICUBIC : SWS_BILINEAR))
+    {
+        LOG_ERROR("video sync scaler convert failed");
+        return nullptr;
+    }
+    if (av_frame_copy_props(raw_frame, frame.raw()) < 0)
+    {
+        LOG_WARN("video sync failed to copy frame properties after conversion");
+    }
+    const auto convert_end = steady_clock::now();
+    convert_cost_ = ((convert_cost_ * 7) + std::chrono::duration_cast<steady_clock::duration>(convert_end - convert_start)) / 8;
+
+    auto converted = std::make_shared<media_frame>();
+    av_frame_move_ref(converted->raw(), raw_frame);
+    return converted;
+}
+
+std::shared_ptr<media_frame> video_sync_thread::shrink_frame(video_scaler &scaler, const AVFrame *raw, double scale)
+{
+    auto shrunk = std::make_shared<media_frame>();
+    AVFrame *small = shrunk->raw();
+    small->format = AV_PIX_FMT_YUV420P;
+    small->width = std::max(2, static_cast<int>(raw->width * scale) & ~1);
+    small->height = std::max(2, static_cast<int>(raw->height * scale) & ~1);
+    if (av_frame_get_buffer(small, 32) < 0 || av_frame_copy_props(small, raw) < 0 || !scaler.convert(raw, small, SWS_BICUBIC))
+    {
+        return nullptr;
+    }
+    return shrunk;
+}
+
+void video_sync_thread::cache_frame(const std::shared_ptr<media_frame> &converted, double pts, int serial, bool keyframe)
+{
+    const AVFrame *raw = converted->raw();
+    const size_t frame_bytes = frame_cache::frame_bytes(raw);
+    if (frame_bytes <= cache_.frame_budget_bytes() || !paused_.load())
+    {
+        cache_.insert(pts, serial, keyframe, converted);
+        return;
+    }
+
+    const double scale = std::sqrt(static_cast<double>(cache_.frame_budget_bytes()) / static_cast<double>(frame_bytes));
+    auto downscaled = shrink_frame(cache_scaler_, raw, scale);
+    if (downscaled == nullptr)
+    {
+        LOG_WARN("video sync failed to downscale frame for step cache");
+        return;
+    }
+    cache_.insert(pts, serial, keyframe, downscaled);
+}
+
+void video_sync_thread::present(const std::shared_ptr<media_frame> &source, const std::shared_ptr<media_frame> &converted, double pts, int serial, bool keyframe)
+{
+    shown_source_ = source;
+    emit frame_ready(converted);
+    cache_frame(converted, pts, serial, keyframe);
+    current_pts_ = pts;
+    current_serial_ = serial;
+    head_pts_ = pts;
+}
+
+void video_sync_thread::request_step(int direction)
+{
+    LOG_INFO("video sync thread step requested direction {}", direction);
+    step_request_.fetch_add(direction > 0 ? 1 : -1);
+}
+
+void video_sync_thread::request_step_to(double target)
+{
+    LOG_INFO("video sync thread step to {:.3f} requested", target);
+    step_request_.store(0);
+    step_target_.store(target);
+}
+
+frame_cache::stats video_sync_thread::cache_stats() const { return cache_.read(); }
+
+video_scaler::stats video_sync_thread::scale_stats() const { return scaler_.read(); }
+
+void video_sync_thread::set_reverse_seek_handler(std::function<void(double)> handler)
+{
+    std::lock_guard<std::mutex> lock(reverse_mutex_);
+    reverse_seek_ = std::move(handler);
+}
+
+void video_sync_thread::set_reverse(bool enabled)
+{
+    LOG_INFO("video sync thread reverse playback {}", enabled);
+    std::lock_guard<std::mutex> lock(reverse_mutex_);
+    reverse_.store(enabled);
+}
+
+bool video_sync_thread::reverse() const { return reverse_.load(); }
+
+void video_sync_thread::set_trick_rate(double rate)
+{
+    LOG_INFO("video sync thread trick rate {}", rate);
+    trick_rate_.store(rate);
+}
+
+double video_sync_thread::trick_rate() const { return trick_rate_.load(); }
+
+void video_sync_thread::show_cached(const std::shared_ptr<media_frame> &cached, double pts)
+{
+    shown_source_ = cached;
+    emit frame_ready(cached);
+    current_pts_ = pts;
+    clock_->set(pts, current_serial_);
+    emit stepped(pts);
+}
+
+void video_sync_thread::refresh_paused_frame()
+{
+    if (shown_source_ == nullptr)
+    {
+        return;
+    }
+
+    auto converted = convert_frame(*shown_source_);
+    if (converted == nullptr)
+    {
+        return;
+    }
+    LOG_DEBUG("video sync reconverted paused frame at {:.3f} for display {}x{}", current_pts_, display_width_.load(), display_height_.load());
+    emit frame_ready(converted);
+}
+
+void video_sync_thread::service_steps(std::shared_ptr<media_frame> &pending)
+{
+    if (display_resized_.exchange(false))
+    {
+        refresh_paused_frame();
+    }
+
+    const double target = step_target_.exchange(-1.0);
+    if (target >= 0.0)
+    {
+        pending.reset();
+        step_to(target);
+        return;
+    }
+
+    int request = step_request_.exchange(0);
+    while (request != 0 && !stop_ && !isInterruptionRequested())
+    {
+        if (request > 0)
+        {
+            step_forward(pending);
+            request--;
+            continue;
+        }
+
+        double cached_pts = 0.0;
+        auto cached = cache_.previous(current_pts_, current_serial_, cached_pts);
+        if (cached == nullptr)
+        {
+            LOG_INFO("video step backward from {:.3f} missed cache", current_pts_);
+            emit step_cache_miss(current_pts_);
+            return;
+        }
+        show_cached(cached, cached_pts);
+        request++;
+    }
+}
+
+bool video_sync_thread::next_current_frame(std::shared_ptr<media_frame> &source)
+{
+    while (!stop_ && !isInterruptionRequested())
+    {
+        if (source != nullptr && !source->flush() && source->serial() == packet_queue_->serial())
+        {
+            return true;
+        }
+        if (end_of_stream_serial_ == packet_queue_->serial())
+        {
+            LOG_DEBUG("video sync thread step ignored at end of stream");
+            return false;
+        }
+        if (!paused_.load() || step_target_.load() >= 0.0 || step_request_.load() < 0)
+        {
+            return false;
+        }
+        if (!frame_queue_->try_pop_for(source, k_reverse_poll))
+        {
+            if (frame_queue_->aborted())
+            {
+                LOG_INFO("video sync thread step found frame queue aborted");
+                stop_ = true;
+                return false;
+            }
+            source.reset();
+            continue;
+        }
+        if (source == nullptr)
+        {
+            LOG_INFO("video sync thread step reached end of stream");
+            end_of_stream_serial_ = packet_queue_->serial();
+            return false;
+        }
+    }
+    return false;
+}
+
+void video_sync_thread::step_forward(std::shared_ptr<media_frame> &pending)
+{
+    if (current_pts_ < head_pts_)
+    {
+        double cached_pts = 0.0;
+        auto cached = cache_.next(current_pts_, current_serial_, cached_pts);
+        if (cached != nullptr && cached_pts <= head_pts_)
+        {
+            show_cached(cached, cached_pts);
+            return;
+        }
+    }
+
+    std::shared_ptr<media_frame> source = std::move(pending);
+    pending.reset();
+    if (!next_current_frame(source))
+    {
+        return;
+    }
+
+    const double pts = frame_pts(*source);
+    auto converted = convert_frame(*source);
+    if (converted == nullptr)
+    {
+        return;
+    }
+    present(source, converted, pts, source->serial(), is_keyframe(source->raw()));
+    clock_->set(pts, source->serial());
+    emit stepped(pts);
+}
+
+void video_sync_thread::step_to(double target)
+{
+    std::shared_ptr<media_frame> source;
+    while (next_current_frame(source))
+    {
+        const double pts = frame_pts(*source);
+        const double duration = frame_duration(source->raw(), pts);
+        last_pts_ = pts;
+        last_duration_ = duration;
+
+        auto converted = convert_frame(*source);
+        if (converted == nullptr)
+        {
+            source.reset();
+            continue;
+        }
+
+        if (pts + duration > target)
+        {
+            present(source, converted, pts, source->serial(), is_keyframe(source->raw()));
+            clock_->set(pts, source->serial());
+            emit stepped(pts);
+            return;
+        }
+        cache_frame(converted, pts, source->serial(), is_keyframe(source->raw()));
+        source.reset();
+    }
+}
+
+bool video_sync_thread::begin_reverse_segment(reverse_segment &segment, double end)
+{
+    segment.frames.clear();
+    segment.end = end;
+    segment.done = false;
+    segment.trimmed = false;
+    segment.spilled_bytes = 0;
+    segment.last_activity = steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(reverse_mutex_);
+    if (!reverse_.load() || !reverse_seek_)
+    {
+        segment.done = true;
+        return false;
+    }
+    reverse_seek_(std::max(0.0, end - k_reverse_seek_margin));
+    segment.serial = packet_queue_->serial();
+    return true;
+}
+
+bool video_sync_thread::collect_reverse_frame(reverse_segment &segment, steady_clock::duration timeout)
+{
+    if (segment.done)
+    {
+        return false;
+    }
+
+    std::shared_ptr<media_frame> frame;
+    if (!frame_queue_->try_pop_for(frame, timeout))
+    {
+        if (frame_queue_->aborted() || steady_clock::now() - segment.last_activity > k_reverse_collect_timeout)
+        {
+            LOG_DEBUG("video reverse segment ending at {:.3f} closed after {} frames", segment.end, segment.frames.size());
+            segment.done = true;
+        }
+        return false;
+    }
+
+    segment.last_activity = steady_clock::now();
+    if (frame == nullptr)
+    {
+        LOG_INFO("video sync thread received null frame during reverse playback");
+        segment.done = true;
+        stop_ = true;
+        return false;
+    }
+    if (frame->flush() || frame->serial() != segment.serial)
+    {
+        return true;
+    }
+
+    const double pts = frame_pts(*frame);
+    if (pts >= segment.end - k_reverse_seek_margin)
+    {
+        segment.done = true;
+        return true;
+    }
+
+    segment.frames.push_back(reverse_frame{std::move(frame), pts, 0});
+    spill_reverse_frames(segment);
+    return true;
+}
+
+void video_sync_thread::spill_reverse_frames(reverse_segment &segment)
+{
+    if (segment.frames.size() > k_reverse_frame_budget)
+    {
+        auto item = segment.frames.begin() + static_cast<std::ptrdiff_t>(segment.frames.size() - k_reverse_frame_budget - 1);
+        auto spilled = shrink_frame(spill_scaler_, item->frame->raw(), k_reverse_spill_scale);
+        if (spilled == nullptr)
+        {
+            LOG_WARN("video reverse failed to spill frame {:.3f} dropping it", item->pts);
+            segment.frames.erase(item);
+        }
+        else
+        {
+            item->frame = std::move(spilled);
+            item->spilled_bytes = frame_cache::frame_bytes(item->frame->raw());
+            segment.spilled_bytes += item->spilled_bytes;
+        }
+    }
+
+    while (segment.spilled_bytes > k_reverse_spill_bytes && segment.frames.size() > k_reverse_frame_budget)
+    {
+        if (!segment.trimmed)
+        {
+            LOG_INFO("video reverse segment ending at {:.3f} over spill budget earliest frames will be decoded again", segment.end);
+            segment.trimmed = true;
+        }
+        segment.spilled_bytes -= segment.frames.front().spilled_bytes;
+        segment.frames.pop_front();
+    }
+}
+
+void video_sync_thread::collect_reverse_segment(reverse_segment &segment)
+{
+    while (!segment.done && reverse_.load() && !stop_ && !isInterruptionRequested())
+    {
+        collect_reverse_frame(segment, k_reverse_poll);
+    }
+}
+
+void video_sync_thread::run_reverse()
+{
+    const double start = current_pts_ >= 0.0 ? current_pts_ : clock_->get();
+    LOG_INFO("video sync thread reverse playback from {:.3f}", start);
+
+    reverse_segment current;
+    begin_reverse_segment(current, start);
+    collect_reverse_segment(current);
+
+    double previous_pts = start;
+    auto last_present = steady_clock::now();
+    while (reverse_.load() && !stop_ && !isInterruptionRequested())
+    {
+        if (current.frames.empty())
+        {
+            if (reverse_.load() && !stop_)
+            {
+                LOG_INFO("video sync thread reverse playback reached start");
+                reverse_.store(false);
+                emit reverse_reached_start();
+            }
+            return;
+        }
+
+        reverse_segment next;
+        begin_reverse_segment(next, current.frames.front().pts);
+
+        while (!current.frames.empty() && reverse_.load() && !stop_ && !isInterruptionRequested())
+        {
+            reverse_frame item = std::move(current.frames.back());
+            current.frames.pop_back();
+
+            const double gap = previous_pts > item.pts ? std::min(previous_pts - item.pts, k_reverse_max_gap) : k_default_frame_duration;
+            const double rate = std::max(clock_->rate(), 0.1);
+            const auto present_at = last_present + std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(gap / rate));
+            while (steady_clock::now() < present_at && reverse_.load() && !stop_)
+            {
+                if (!collect_reverse_frame(next, steady_clock::duration::zero()))
+                {
+                    std::this_thread::sleep_until(std::min(present_at, steady_clock::now() + k_reverse_poll));
+                }
+            }
+
+            auto converted = convert_frame(*item.frame);
+            if (converted != nullptr)
+            {
+                shown_source_ = item.frame;
+                emit frame_ready(converted);
+                current_pts_ = item.pts;
+                current_serial_ = current.serial;
+                clock_->set(item.pts, current.serial);
+            }
+            previous_pts = item.pts;
+            last_present = std::max(present_at, steady_clock::now() - k_max_sleep_slice);
+        }
+
+        collect_reverse_segment(next);
+        current = std::move(next);
+    }
+}
+
+void video_sync_thread::run_trick()
+{
+    LOG_INFO("video sync thread trick play at {}x", trick_rate_.load());
+    double previous_pts = -1.0;
+    auto last_present = steady_clock::now();
+
+    while (!stop_ && !isInterruptionRequested())
+    {
+        const double rate = trick_rate_.load();
+        if (rate == 0.0 || paused_.load())
+        {
+            return;
+        }
+
+        std::shared_ptr<media_frame> frame;
+        if (!frame_queue_->try_pop_for(frame, k_reverse_poll))
+        {
+            if (frame_queue_->aborted())
+            {
+                return;
+            }
+            continue;
+        }
+        if (frame == nullptr)
+        {
+            LOG_INFO("video sync thread received null frame during trick play");
+            stop_ = true;
+            return;
+        }
+        if (frame->flush())
+        {
+            previous_pts = -1.0;
+            continue;
+        }
+        if (frame->serial() != packet_queue_->serial())
+        {
+            count_drop(drop_reason::stale, 0.0, 0.0);
+            continue;
+        }
+
+        const double pts = frame_pts(*frame);
+        if (previous_pts >= 0.0 && (rate > 0.0 ? pts <= previous_pts : pts >= previous_pts))
+        {
+            continue;
+        }
+
+        const double gap = previous_pts >= 0.0 ? std::min(std::abs(pts - previous_pts) / std::abs(rate), k_trick_max_gap) : 0.0;
+        const auto present_at = last_present + std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(gap));
+        while (steady_clock::now() < present_at && trick_rate_.load() != 0.0 && !stop_)
+        {
+            std::this_thread::sleep_until(std::min(present_at, steady_clock::now() + k_reverse_poll));
+        }
+        if (trick_rate_.load() == 0.0)
+        {
+            return;
+        }
+
+        auto converted = convert_frame(*frame);
+        if (converted != nullptr)
+        {
+            shown_source_ = frame;
+            emit frame_ready(converted);
+            current_pts_ = pts;
+            current_serial_ = frame->serial();
+            clock_->set(pts, frame->serial());
+        }
+        previous_pts = pts;
+        last_present = std::max(present_at, steady_clock::now() - k_max_sleep_slice);
+    }
 }
 
 void video_sync_thread::run()
 {
     LOG_INFO("video sync thread run loop started");
     std::shared_ptr<media_frame> frame;
-    auto render_frame = std::make_shared<media_frame>();
+    steady_clock::time_point last_vsync;
 
     while (!stop_ && !isInterruptionRequested())
     {
         if (paused_.load())
         {
+            std::shared_ptr<media_frame> no_pending;
+            service_steps(no_pending);
             msleep(10);
             continue;
         }
 
+        if (reverse_.load())
+        {
+            run_reverse();
+            continue;
+        }
+
+        if (trick_rate_.load() != 0.0)
+        {
+            run_trick();
+            continue;
+        }
+
         if (!frame_queue_->pop(frame))
         {
             LOG_INFO("video sync thread queue popped false exiting");
@@ -51,33 +799,56 @@ void video_sync_thread::run()
 
         if (!frame->flush() && frame->serial() != packet_queue_->serial())
         {
+            count_drop(drop_reason::stale, 0.0, 0.0);
             continue;
         }
 
         if (frame->flush())
         {
             LOG_INFO("video sync thread received flush");
+            last_pts_ = -1.0;
+            cache_.clear();
             continue;
         }
 
         auto *decoded_frame = frame->raw();
-        int64_t timestamp = decoded_frame->pts;
-        if (timestamp == AV_NOPTS_VALUE)
+        const double pts = frame_pts(*frame);
+        const double duration = frame_duration(decoded_frame, pts);
+        last_pts_ = pts;
+        last_duration_ = duration;
+
+        if (should_drop_late(pts, duration, frame->serial()))
         {
-            timestamp = decoded_frame->best_effort_timestamp;
+            count_drop(drop_reason::late, pts, pts - clock_->get());
+            continue;
         }
 
-        const double pts = timestamp == AV_NOPTS_VALUE ? clock_->get() : static_cast<double>(timestamp) * av_q2d(time_base_);
         bool discard_frame = false;
+        bool frame_consumed = false;
+        bool has_deadline = false;
+        steady_clock::time_point present_deadline;
+        steady_clock::time_point present_vsync;
 
         while (!stop_ && !isInterruptionRequested())
         {
             if (paused_.load())
             {
+                service_steps(frame);
+                if (frame == nullptr)
+                {
+                    frame_consumed = true;
+                    break;
+                }
                 msleep(10);
                 continue;
             }
 
+            if (reverse_.load() || trick_rate_.load() != 0.0)
+            {
+                frame_consumed = true;
+                break;
+            }
+
             if (frame->serial() != packet_queue_->serial())
             {
                 discard_frame = true;
@@ -94,66 +865,92 @@ void video_sync_thread::run()
             const double master_clock = clock_->get();
             const double diff = pts - master_clock;
             const double playback_rate = clock_->rate();
+            const auto now = steady_clock::now();
 
             LOG_TRACE("video pts {:.3f} raw pts {} master clock {:.3f} diff {:.3f}", pts, decoded_frame->pts, master_clock, diff);
-            if (diff > 0.01)
+            if (diff <= 0.0)
             {
-                auto sleep_ms = static_cast<uint64_t>((diff / playback_rate) * 1000.0);
-                if (sleep_ms > 50)
-                {
-                    sleep_ms = 50;
-                }
-                msleep(sleep_ms);
+                break;
             }
-            else
+
+            auto deadline = now + std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(diff / playback_rate));
+            present_vsync = steady_clock::time_point{};
+            if (vsync_pacer_ != nullptr && vsync_pacer_->ready(now))
             {
-                break;
+                present_vsync = vsync_pacer_->align(deadline);
+                deadline = present_vsync - (vsync_pacer_->interval() / 2);
+            }
+            const auto wake_time = deadline - convert_cost_ - k_spin_window;
+            if (wake_time > now)
+            {
+                std::this_thread::sleep_until(std::min(wake_time, now + k_max_sleep_slice));
+                continue;
             }
+
+            const auto spin_until = deadline - convert_cost_;
+            while (steady_clock::now() < spin_until)
+            {
+                std::this_thread::yield();
+            }
+            present_deadline = deadline;
+            has_deadline = true;
+            break;
         }
 
         if (stop_ || isInterruptionRequested())
         {
             break;
         }
+        if (frame_consumed)
+        {
+            continue;
+        }
         if (discard_frame || frame->serial() != packet_queue_->serial())
         {
+            count_drop(drop_reason::stale, pts, 0.0);
             continue;
         }
 
-        const double final_diff = pts - clock_->get();
-        if (final_diff < -0.2)
+        if (has_deadline && present_vsync != steady_clock::time_point{} && std::chrono::abs(present_vsync - last_vsync) < vsync_pacer_->interval() / 2 &&
+            !frame_queue_->empty())
         {
-            if (!frame_queue_->empty())
-            {
-                LOG_WARN("dropping video frame pts {:.3f} diff {:.3f}", pts, final_diff);
-                continue;
-            }
+            count_drop(drop_reason::cadence, pts, pts - clock_->get());
+            continue;
         }
 
-        auto *raw_frame = render_frame->raw();
-
-        if (raw_frame->width != frame->raw()->width || raw_frame->height != frame->raw()->height || raw_frame->format != AV_PIX_FMT_YUV420P)
+        if (should_drop_late(pts, duration, frame->serial()))
         {
-            av_frame_unref(raw_frame);
-            raw_frame->format = AV_PIX_FMT_YUV420P;
-            raw_frame->width = frame->raw()->width;
-            raw_frame->height = frame->raw()->height;
-            if (av_frame_get_buffer(raw_frame, 32) < 0)
-            {
-                LOG_ERROR("video sync av frame get buffer failed");
-                continue;
-            }
+            count_drop(drop_reason::late, pts, pts - clock_->get());
+            continue;
         }
 
-        if (!scaler_.convert(frame->raw(), raw_frame))
+        auto converted = convert_frame(*frame);
+        if (converted == nullptr)
         {
-            LOG_ERROR("video sync scaler convert failed");
             continue;
         }
+        present(frame, converted, pts, frame->serial(), is_keyframe(decoded_frame));
 
-        auto frame_to_emit = std::make_shared<media_frame>();
-        av_frame_move_ref(frame_to_emit->raw(), raw_frame);
-        emit frame_ready(frame_to_emit);
+        if (vsync_pacer_ != nullptr && present_vsync != steady_clock::time_point{})
+        {
+            vsync_pacer_->expect_present(present_vsync);
+            last_vsync = present_vsync;
+        }
+
+        if (has_deadline)
+        {
+            record_present_error(std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - present_deadline).count());
+        }
+        else
+        {
+            record_present_error(static_cast<int64_t>((clock_->get() - pts) * 1000000.0));
+        }
+
+        if (clock_->master() == clock_master::video && std::abs(clock_->get() - pts) > k_video_master_resync_threshold)
+        {
+            LOG_DEBUG("video master clock resync to pts {:.3f}", pts);
+            clock_->set(pts, frame->serial());
+        }
     }
     LOG_INFO("video sync thread run loop finished");
 }
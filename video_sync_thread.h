@@ -1,11 +1,18 @@
 #ifndef VIDEO_SYNC_THREAD_H
 #define VIDEO_SYNC_THREAD_H
 
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <QThread>
 #include "av_clock.h"
 #include "safe_queue.h"
 #include "video_scaler.h"
 #include "media_objects.h"
+#include "present_histogram.h"
+#include "vsync_pacer.h"
+#include "frame_cache.h"
 
 class video_sync_thread : public QThread
 {
@@ -18,22 +25,126 @@ class video_sync_thread : public QThread
                       av_clock *clk,
                       QObject *parent = nullptr);
 
+   public:
+    struct frame_drop_stats
+    {
+        uint64_t stale = 0;
+        uint64_t late = 0;
+        uint64_t cadence = 0;
+    };
+
    public:
     void stop();
     void paused(bool p);
+    void set_vsync_pacer(vsync_pacer *pacer);
+    void set_display_size(int width, int height);
+    void request_step(int direction);
+    void request_step_to(double target);
+    void set_reverse_seek_handler(std::function<void(double)> handler);
+    void set_reverse(bool enabled);
+    [[nodiscard]] bool reverse() const;
+    void set_trick_rate(double rate);
+    [[nodiscard]] double trick_rate() const;
+    [[nodiscard]] frame_cache::stats cache_stats() const;
+    [[nodiscard]] video_scaler::stats scale_stats() const;
+    [[nodiscard]] frame_drop_stats frame_drops() const;
+    [[nodiscard]] const present_histogram &present_errors() const;
 
    protected:
     void run() override;
 
    signals:
     void frame_ready(std::shared_ptr<media_frame> frame);
+    void stepped(double pts);
+    void step_cache_miss(double pts);
+    void reverse_reached_start();
+
+   private:
+    enum class drop_reason
+    {
+        stale,
+        late,
+        cadence
+    };
+
+    struct reverse_frame
+    {
+        std::shared_ptr<media_frame> frame;
+        double pts = 0.0;
+        size_t spilled_bytes = 0;
+    };
+
+    struct reverse_segment
+    {
+        std::deque<reverse_frame> frames;
+        double end = 0.0;
+        int serial = -1;
+        bool done = false;
+        bool trimmed = false;
+        size_t spilled_bytes = 0;
+        std::chrono::steady_clock::time_point last_activity;
+    };
+
+   private:
+    void record_present_error(int64_t error_us);
+    void count_drop(drop_reason reason, double pts, double diff);
+    [[nodiscard]] double frame_duration(const AVFrame *frame, double pts) const;
+    [[nodiscard]] bool should_drop_late(double pts, double duration, int serial);
+    [[nodiscard]] double frame_pts(const media_frame &frame) const;
+    [[nodiscard]] static bool is_keyframe(const AVFrame *frame);
+    [[nodiscard]] bool downscale_target(const AVFrame *frame, int &width, int &height) const;
+    std::shared_ptr<media_frame> convert_frame(const media_frame &frame);
+    [[nodiscard]] static std::shared_ptr<media_frame> shrink_frame(video_scaler &scaler, const AVFrame *raw, double scale);
+    void cache_frame(const std::shared_ptr<media_frame> &converted, double pts, int serial, bool keyframe);
+    void present(const std::shared_ptr<media_frame> &source, const std::shared_ptr<media_frame> &converted, double pts, int serial, bool keyframe);
+    void show_cached(const std::shared_ptr<media_frame> &cached, double pts);
+    void refresh_paused_frame();
+    void service_steps(std::shared_ptr<media_frame> &pending);
+    bool next_current_frame(std::shared_ptr<media_frame> &source);
+    void step_forward(std::shared_ptr<media_frame> &pending);
+    void step_to(double target);
+    void run_reverse();
+    bool begin_reverse_segment(reverse_segment &segment, double end);
+    bool collect_reverse_frame(reverse_segment &segment, std::chrono::steady_clock::duration timeout);
+    void spill_reverse_frames(reverse_segment &segment);
+    void collect_reverse_segment(reverse_segment &segment);
+    void run_trick();
 
    private:
     bool stop_ = false;
     video_scaler scaler_;
+    video_scaler cache_scaler_;
+    video_scaler spill_scaler_;
     av_clock *clock_ = nullptr;
     AVRational time_base_{0, 1};
+    std::shared_ptr<media_frame> render_frame_;
+    std::shared_ptr<media_frame> shown_source_;
+    frame_cache cache_;
+    std::atomic<int> step_request_{0};
+    std::atomic<double> step_target_{-1.0};
+    std::atomic<bool> reverse_{false};
+    std::mutex reverse_mutex_;
+    std::function<void(double)> reverse_seek_;
+    std::atomic<double> trick_rate_{0.0};
+    double current_pts_ = -1.0;
+    double head_pts_ = -1.0;
+    int current_serial_ = -1;
+    int end_of_stream_serial_ = -1;
     std::atomic<bool> paused_{false};
+    present_histogram present_errors_;
+    std::chrono::steady_clock::duration convert_cost_{0};
+    bool passthrough_ = false;
+    int output_width_ = 0;
+    int output_height_ = 0;
+    std::atomic<int> display_width_{0};
+    std::atomic<int> display_height_{0};
+    std::atomic<bool> display_resized_{false};
+    vsync_pacer *vsync_pacer_ = nullptr;
+    double last_pts_ = -1.0;
+    double last_duration_ = 0.0;
+    std::atomic<uint64_t> stale_drops_{0};
+    std::atomic<uint64_t> late_drops_{0};
+    std::atomic<uint64_t> cadence_drops_{0};
     safe_queue<std::shared_ptr<media_frame>> *frame_queue_ = nullptr;
     safe_queue<std::shared_ptr<media_packet>> *packet_queue_ = nullptr;
 };
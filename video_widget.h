@@ -2,24 +2,17 @@
 #define VIDEO_WIDGET_H
 
 #include <memory>
-#include <utility>
-#include <QOpenGLWidget>
-#include <QOpenGLFunctions>
-#include <QOpenGLContext>
-#include <QOpenGLShaderProgram>
-#include <QOpenGLTexture>
-#include <QMatrix4x4>
+#include <QWidget>
+#include <QSize>
 #include "media_objects.h"
-
-extern "C"
-{
-#include <libavutil/pixfmt.h>
-#include "libavutil/pixdesc.h"
-}
+#include "vsync_pacer.h"
+#include "video_renderer.h"
+#include "video_render_thread.h"
 
 class QString;
+class QWindow;
 
-class video_widget : public QOpenGLWidget, protected QOpenGLFunctions
+class video_widget : public QWidget
 {
     Q_OBJECT
 
@@ -27,36 +20,38 @@ class video_widget : public QOpenGLWidget, protected QOpenGLFunctions
     explicit video_widget(QWidget *parent = nullptr);
     ~video_widget() override;
 
+   public:
+    using upload_stats = video_renderer::upload_stats;
+    using render_stats = video_render_thread::render_stats;
+
    public:
     void clear();
+    void submit_frame(std::shared_ptr<media_frame> frame);
     [[nodiscard]] bool has_frame() const;
     [[nodiscard]] bool save_current_frame(const QString &path) const;
+    [[nodiscard]] vsync_pacer *pacer();
+    [[nodiscard]] upload_stats upload_timing() const;
+    [[nodiscard]] render_stats render_timing() const;
+    [[nodiscard]] QSize drawable_size() const;
 
-   public slots:
-    void on_frame_ready(std::shared_ptr<media_frame> frame);
+   signals:
+    void drawable_size_changed(int width, int height);
 
    protected:
-    void initializeGL() override;
-    void resizeGL(int w, int h) override;
-    void paintGL() override;
+    bool event(QEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
 
    private:
-    void cleanup_gl_resources();
-    void update_color_matrix(const AVFrame *frame);
-    static QMatrix4x4 get_color_matrix(AVColorSpace space, AVColorRange range);
+    void update_refresh_rate();
+    void update_drawable_size();
 
    private:
-    int tex_width_ = 0;
-    int tex_height_ = 0;
-    GLuint textures_[3] = {0, 0, 0};
-    bool texture_inited_ = false;
-    QOpenGLShaderProgram *program_ = nullptr;
-    std::shared_ptr<media_frame> current_frame_ = nullptr;
-
-    AVColorSpace current_color_space_ = AVCOL_SPC_UNSPECIFIED;
-    AVColorRange current_color_range_ = AVCOL_RANGE_UNSPECIFIED;
-    QMatrix4x4 color_matrix_;
-    int matrix_uniform_loc_ = -1;
+    QSize drawable_size_;
+    vsync_pacer pacer_;
+    QWindow *surface_ = nullptr;
+    QWidget *surface_container_ = nullptr;
+    std::unique_ptr<video_render_thread> render_thread_;
 };
 
 #endif
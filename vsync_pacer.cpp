@@ -0,0 +1,102 @@
+#include <cstdlib>
+#include "log.h"
+#include "vsync_pacer.h"
+
+namespace
+{
+constexpr int64_t k_max_swap_periods = 4;
+constexpr uint32_t k_min_stable_swaps = 8;
+constexpr int64_t k_swap_stale_ns = 1000000000;
+
+int64_t to_ns(vsync_pacer::clock::time_point when)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+}
+}  // namespace
+
+void vsync_pacer::set_refresh_rate(double hz)
+{
+    if (hz <= 1.0)
+    {
+        return;
+    }
+
+    const auto nominal = static_cast<int64_t>(1000000000.0 / hz);
+    const int64_t current = interval_ns_.load();
+    if (current > 0 && std::llabs(current - nominal) < nominal / 10)
+    {
+        return;
+    }
+
+    LOG_INFO("vsync pacer refresh rate {:.2f} Hz", hz);
+    interval_ns_.store(nominal);
+    stable_swaps_.store(0);
+}
+
+void vsync_pacer::on_frame_swapped(clock::time_point when)
+{
+    const int64_t now_ns = to_ns(when);
+    const int64_t previous_ns = last_swap_ns_.exchange(now_ns);
+    int64_t interval = interval_ns_.load();
+    if (interval <= 0)
+    {
+        return;
+    }
+
+    if (previous_ns > 0)
+    {
+        const int64_t delta = now_ns - previous_ns;
+        const int64_t periods = (delta + (interval / 2)) / interval;
+        if (periods >= 1 && periods <= k_max_swap_periods)
+        {
+            const int64_t measured = delta / periods;
+            if (std::llabs(measured - interval) < interval / 4)
+            {
+                interval = ((interval * 15) + measured) / 16;
+                interval_ns_.store(interval);
+                stable_swaps_.fetch_add(1);
+            }
+        }
+    }
+
+    const int64_t expected_ns = expected_vsync_ns_.exchange(0);
+    if (expected_ns > 0 && now_ns > expected_ns + (interval / 2))
+    {
+        missed_vsyncs_.fetch_add(static_cast<uint64_t>((now_ns - expected_ns + (interval / 2)) / interval));
+    }
+}
+
+void vsync_pacer::expect_present(clock::time_point vsync) { expected_vsync_ns_.store(to_ns(vsync)); }
+
+bool vsync_pacer::ready(clock::time_point now) const
+{
+    const int64_t last_swap_ns = last_swap_ns_.load();
+    return interval_ns_.load() > 0 && stable_swaps_.load() >= k_min_stable_swaps && last_swap_ns > 0 && to_ns(now) - last_swap_ns < k_swap_stale_ns;
+}
+
+vsync_pacer::clock::duration vsync_pacer::interval() const
+{
+    return std::chrono::duration_cast<clock::duration>(std::chrono::nanoseconds(interval_ns_.load()));
+}
+
+vsync_pacer::clock::time_point vsync_pacer::align(clock::time_point deadline) const
+{
+    const int64_t interval = interval_ns_.load();
+    const int64_t last_swap_ns = last_swap_ns_.load();
+    if (interval <= 0 || last_swap_ns <= 0)
+    {
+        return deadline;
+    }
+
+    const int64_t offset = to_ns(deadline) - last_swap_ns;
+    const int64_t periods = offset >= 0 ? (offset + (interval / 2)) / interval : -((-offset + (interval / 2)) / interval);
+    return clock::time_point(std::chrono::duration_cast<clock::duration>(std::chrono::nanoseconds(last_swap_ns + (periods * interval))));
+}
+
+uint64_t vsync_pacer::missed_vsyncs() const { return missed_vsyncs_.load(); }
+
+double vsync_pacer::refresh_rate() const
+{
+    const int64_t interval = interval_ns_.load();
+    return interval > 0 ? 1000000000.0 / static_cast<double>(interval) : 0.0;
+}
@@ -0,0 +1,37 @@
+#ifndef VSYNC_PACER_H
+#define VSYNC_PACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+class vsync_pacer
+{
+   public:
+    using clock = std::chrono::steady_clock;
+
+   public:
+    vsync_pacer() = default;
+    vsync_pacer(const vsync_pacer &) = delete;
+    vsync_pacer &operator=(const vsync_pacer &) = delete;
+
+   public:
+    void set_refresh_rate(double hz);
+    void on_frame_swapped(clock::time_point when);
+    void expect_present(clock::time_point vsync);
+
+    [[nodiscard]] bool ready(clock::time_point now) const;
+    [[nodiscard]] clock::duration interval() const;
+    [[nodiscard]] clock::time_point align(clock::time_point deadline) const;
+    [[nodiscard]] uint64_t missed_vsyncs() const;
+    [[nodiscard]] double refresh_rate() const;
+
+   private:
+    std::atomic<int64_t> interval_ns_{0};
+    std::atomic<int64_t> last_swap_ns_{0};
+    std::atomic<int64_t> expected_vsync_ns_{0};
+    std::atomic<uint32_t> stable_swaps_{0};
+    std::atomic<uint64_t> missed_vsyncs_{0};
+};
+
+#endif